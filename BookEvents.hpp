@@ -0,0 +1,225 @@
+#pragma once
+#include "Order.hpp"
+#include "Ring.hpp"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+using namespace std;
+
+// Structured execution events emitted by the book in place of console output.
+// Events are published into an EventRing under the book's lock and drained by
+// an EventLogger thread, so formatting and I/O never run on the matching path.
+
+enum class EventType : uint8_t {
+    Accept,     // order accepted (limit orders now rest; market/IOC about to match)
+    Fill,       // trade between orderId (aggressor) and contraOrderId (resting)
+    CancelAck,
+    ModifyAck,
+    Expired,    // unfilled market/IOC remainder discarded
+    Reject,
+    Reset,
+    Triggered   // resting stop elected; it executes as a market order next
+};
+
+enum class RejectReason : uint8_t { None, PriceOutOfRange, DuplicateId, PoolExhausted };
+
+struct BookEvent {
+    uint64_t sequence = 0;      // per-book event number
+    Price price = 0;            // Accept/ModifyAck: limit (stop) price, Fill: trade price, Triggered: stop price
+    int orderId = 0;
+    int contraOrderId = 0;      // Fill only
+    int quantity = 0;           // Accept/ModifyAck: size, Fill: traded, CancelAck/Expired: removed
+    EventType type = EventType::Accept;
+    OrderType orderType = OrderType::Limit;
+    bool buy = false;           // side of orderId
+    RejectReason reason = RejectReason::None;
+};
+
+// Best bid/ask prices with the total quantity resting at each. hasBid/hasAsk
+// say whether that side has a level at all; the quantity alone cannot, since
+// an order modified down to 0 still rests.
+struct TopOfBook {
+    Price bidPrice = 0;
+    int64_t bidQuantity = 0;
+    Price askPrice = 0;
+    int64_t askQuantity = 0;
+    bool hasBid = false;
+    bool hasAsk = false;
+
+    bool operator==(const TopOfBook &o) const {
+        return hasBid == o.hasBid && bidPrice == o.bidPrice && bidQuantity == o.bidQuantity &&
+               hasAsk == o.hasAsk && askPrice == o.askPrice && askQuantity == o.askQuantity;
+    }
+    bool operator!=(const TopOfBook &o) const { return !(*this == o); }
+};
+
+// TopOfBook as published to lock-free readers; sequence counts touch changes,
+// so a poller can tell whether anything moved since its last read.
+struct TopOfBookSnapshot {
+    TopOfBook top;
+    uint64_t sequence = 0;
+};
+
+// Preallocated event ring. Publishing never blocks: when the consumer falls
+// behind, events are dropped and counted.
+class EventRing {
+public:
+    explicit EventRing(size_t capacity = 1 << 16) : ring_(capacity) {}
+
+    void publish(const BookEvent &event) {
+        if(!ring_.push(event))
+            dropped_.fetch_add(1, memory_order_relaxed);
+    }
+
+    bool poll(BookEvent &event) { return ring_.pop(event); }
+    bool empty() const { return ring_.empty(); }
+    uint64_t dropped() const { return dropped_.load(memory_order_relaxed); }
+
+private:
+    SpscRing<BookEvent> ring_;
+    atomic<uint64_t> dropped_{0};
+};
+
+// Destination for drained events.
+class EventSink {
+public:
+    virtual ~EventSink() = default;
+    virtual void write(const BookEvent &event) = 0;
+    virtual void flush() {}
+};
+
+// Discards events (keeps the ring drained).
+class NullEventSink : public EventSink {
+public:
+    void write(const BookEvent &) override {}
+};
+
+// Writes the raw fixed-size records; the stream buffers, so there is no
+// syscall per event.
+class BinaryEventSink : public EventSink {
+public:
+    explicit BinaryEventSink(ostream &out) : out_(out) {}
+    void write(const BookEvent &event) override {
+        out_.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    }
+    void flush() override { out_.flush(); }
+private:
+    ostream &out_;
+};
+
+// Formats events as the human-readable lines the book used to print.
+class TextEventSink : public EventSink {
+public:
+    TextEventSink(ostream &out, const PriceScale &scale) : out_(out), scale_(scale) {}
+
+    void write(const BookEvent &e) override {
+        const char *side = e.buy ? "buy" : "sell";
+        switch(e.type) {
+            case EventType::Accept:
+                if(e.orderType == OrderType::Limit)
+                    out_ << "[OrderBook] addOrder -> ID=" << e.orderId << ", side=" << side << "\n";
+                else if(e.orderType == OrderType::Stop)
+                    out_ << "[OrderBook] stop order -> ID=" << e.orderId << ", side=" << side
+                         << ", stop price " << scale_.toDouble(e.price) << "\n";
+                else
+                    out_ << "[OrderBook] " << (e.orderType == OrderType::IOC ? "IOC" : "Market")
+                         << " order -> ID=" << e.orderId << ", side=" << side << "\n";
+                break;
+            case EventType::Fill:
+                out_ << "Trade executed: " << (e.buy ? "Buy" : "Sell") << " order " << e.orderId
+                     << " and " << (e.buy ? "Sell" : "Buy") << " order " << e.contraOrderId
+                     << " for quantity " << e.quantity
+                     << " at price " << scale_.toDouble(e.price) << "\n";
+                break;
+            case EventType::CancelAck:
+                out_ << "[OrderBook] cancelOrder -> ID=" << e.orderId << "\n";
+                break;
+            case EventType::ModifyAck:
+                out_ << "[OrderBook] modifyOrder -> ID=" << e.orderId << "\n";
+                break;
+            case EventType::Expired:
+                out_ << "[OrderBook] " << (e.orderType == OrderType::IOC ? "IOC" : "Market")
+                     << " order partially filled -> ID=" << e.orderId << ", side=" << side
+                     << ", remaining quantity: " << e.quantity << "\n";
+                break;
+            case EventType::Reject:
+                out_ << "[OrderBook] order rejected (" << reasonName(e.reason) << ") -> ID=" << e.orderId << "\n";
+                break;
+            case EventType::Reset:
+                out_ << "[OrderBook] reset\n";
+                break;
+            case EventType::Triggered:
+                out_ << "[OrderBook] stop order triggered -> ID=" << e.orderId << ", side=" << side
+                     << ", stop price " << scale_.toDouble(e.price) << "\n";
+                break;
+        }
+    }
+    void flush() override { out_.flush(); }
+
+    static const char* reasonName(RejectReason reason) {
+        switch(reason) {
+            case RejectReason::PriceOutOfRange: return "price out of range";
+            case RejectReason::DuplicateId: return "duplicate ID";
+            case RejectReason::PoolExhausted: return "order pool exhausted";
+            default: return "none";
+        }
+    }
+
+private:
+    ostream &out_;
+    PriceScale scale_;
+};
+
+// Background thread draining an EventRing into a sink. It polls on a short
+// sleep rather than being signalled, so publishing costs the matching thread
+// nothing beyond the ring write.
+class EventLogger {
+public:
+    EventLogger(EventRing &ring, EventSink &sink,
+                chrono::microseconds pollInterval = chrono::microseconds(500))
+        : ring_(ring), sink_(sink), pollInterval_(pollInterval) {}
+
+    ~EventLogger() { stop(); }
+
+    void start() {
+        running_ = true;
+        thread_ = thread(&EventLogger::run, this);
+    }
+
+    // Drains whatever is already in the ring, then joins.
+    void stop() {
+        running_ = false;
+        if(thread_.joinable())
+            thread_.join();
+    }
+
+    uint64_t written() const { return written_.load(memory_order_relaxed); }
+
+private:
+    EventRing &ring_;
+    EventSink &sink_;
+    chrono::microseconds pollInterval_;
+    atomic<bool> running_{false};
+    atomic<uint64_t> written_{0};
+    thread thread_;
+
+    void run() {
+        BookEvent event;
+        for(;;) {
+            bool stopping = !running_;
+            bool any = false;
+            while(ring_.poll(event)) {
+                sink_.write(event);
+                written_.fetch_add(1, memory_order_relaxed);
+                any = true;
+            }
+            if(any)
+                sink_.flush();
+            if(stopping)
+                break;
+            this_thread::sleep_for(pollInterval_);
+        }
+    }
+};
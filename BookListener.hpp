@@ -0,0 +1,38 @@
+#pragma once
+#include "BookEvents.hpp"
+using namespace std;
+
+// In-process notification of book activity. BasicOrderBook takes the listener
+// type as a template parameter and calls these members directly, so a
+// concrete listener class is bound statically and its calls inline. Any class
+// providing the same three members can be used; it need not derive from
+// anything. All callbacks run on the matching thread with the book locked.
+//
+//   onFill(event)        - EventType::Fill
+//   onOrderUpdate(event) - every other BookEvent (accept, acks, expiry, reject, reset)
+//   onTopOfBook(top)     - best bid/ask price or size changed
+
+// Default: no listener.
+struct NullBookListener {
+    void onFill(const BookEvent &) {}
+    void onOrderUpdate(const BookEvent &) {}
+    void onTopOfBook(const TopOfBook &) {}
+};
+
+// Runtime-polymorphic listener for callers that choose it dynamically.
+class BookListener {
+public:
+    virtual ~BookListener() = default;
+    virtual void onFill(const BookEvent &) {}
+    virtual void onOrderUpdate(const BookEvent &) {}
+    virtual void onTopOfBook(const TopOfBook &) {}
+};
+
+// Static listener that forwards to a BookListener through virtual dispatch.
+struct DynamicBookListener {
+    BookListener *target = nullptr;
+
+    void onFill(const BookEvent &event) { if(target) target->onFill(event); }
+    void onOrderUpdate(const BookEvent &event) { if(target) target->onOrderUpdate(event); }
+    void onTopOfBook(const TopOfBook &top) { if(target) target->onTopOfBook(top); }
+};
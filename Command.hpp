@@ -0,0 +1,43 @@
+#pragma once
+#include "Order.hpp"
+#include <cstdint>
+using namespace std;
+
+// Commands accepted by the engines (MatchingEngine.hpp, ShardedEngine.hpp)
+// and recorded in the journal (Journal.hpp).
+
+enum class CommandType : uint8_t { Add, Cancel, Modify };
+
+struct Command {
+    CommandType type = CommandType::Add;
+    uint32_t symbol = 0;    // instrument, for ShardedEngine (the single-book engine ignores it)
+    OrderType orderType = OrderType::Limit;
+    bool buy = true;
+    int orderId = 0;
+    int quantity = 0;   // Add: order size, Modify: new size
+    double price = 0.0; // Add: limit price (trigger for a stop), Modify: new price
+};
+
+struct CommandResult {
+    uint64_t sequence = 0;  // position of the command in the engine's (or shard's) total order
+    uint32_t symbol = 0;
+    CommandType type = CommandType::Add;
+    int orderId = 0;
+    bool accepted = false;
+};
+
+// Applies one command to a book owned by the calling thread. Returns whether
+// the book accepted it.
+template<typename Book>
+bool applyCommand(Book &book, const Command &command) {
+    switch(command.type) {
+        case CommandType::Add:
+            return book.addOrder(command.orderId, command.price, command.quantity,
+                                 command.buy ? Side::Buy : Side::Sell, command.orderType);
+        case CommandType::Cancel:
+            return book.cancelOrder(command.orderId);
+        case CommandType::Modify:
+            return book.modifyOrder(command.orderId, command.quantity, command.price);
+    }
+    return false;
+}
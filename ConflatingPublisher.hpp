@@ -0,0 +1,54 @@
+#pragma once
+#include "DepthFeed.hpp"
+#include "Seqlock.hpp"
+#include <atomic>
+#include <cstdint>
+using namespace std;
+
+// Latest-value market data for consumers that poll at their own pace (GUIs,
+// analytics). The book overwrites one depth view after every mutation that
+// changes its best levels; readers copy whatever is current, so a slow
+// reader simply skips intermediate states and the next read always shows
+// the book as of its last mutation. Nothing a reader does can delay the
+// writer: there is no queue to fill and no lock to wait on. The touch alone
+// is available the same way from BasicOrderBook::topOfBook().
+
+static constexpr size_t depthViewLevels = 10;
+
+// Best levels of each side, best first; trivially copyable for the seqlock.
+struct DepthView {
+    uint64_t version = 0;       // publish count, stamped by ConflatingPublisher
+    uint32_t bidCount = 0;
+    uint32_t askCount = 0;
+    DepthLevel bids[depthViewLevels];
+    DepthLevel asks[depthViewLevels];
+};
+
+class ConflatingPublisher {
+public:
+    // Writer side: only the book (under its lock) calls this.
+    void publish(DepthView view) {
+        view.version = ++published_;
+        view_.write(view);
+        version_.store(view.version, memory_order_release);
+    }
+
+    // Any number of readers, any thread.
+    DepthView latest() const { return view_.read(); }
+    uint64_t version() const { return version_.load(memory_order_acquire); }
+
+    // Copies the view into `out` only if it changed since version `seen`,
+    // advancing `seen`. One atomic load when nothing changed.
+    bool readIfNewer(uint64_t &seen, DepthView &out) const {
+        if(version() == seen)
+            return false;
+        out = view_.read();
+        seen = out.version;
+        return true;
+    }
+
+private:
+    Seqlock<DepthView> view_;
+    atomic<uint64_t> version_{0};
+    uint64_t published_ = 0;
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "Order.hpp"
+#include "Ring.hpp"
+#include <map>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+using namespace std;
+
+// Market-by-price (L2) feed. The book keeps per-level quantity and order
+// count anyway; with a DepthRing attached it publishes one DepthUpdate per
+// level a mutation changed, after the mutation completes. A consumer seeds a
+// DepthBook from BasicOrderBook::captureDepth() and applies the increments
+// after the snapshot's sequence; from then on it holds the full depth
+// without touching the book, and can serve top-N views itself.
+
+enum class DepthAction : uint8_t {
+    Add,        // a level appeared
+    Change,     // a level's quantity or order count changed
+    Delete,     // a level emptied
+    Clear       // the book was reset or restored; drop every level
+};
+
+struct DepthUpdate {
+    uint64_t sequence = 0;      // per-book depth update number, no gaps
+    Price price = 0;
+    int64_t quantity = 0;       // total open quantity at the level (0 for Delete)
+    uint32_t orderCount = 0;    // resting orders at the level (0 for Delete)
+    DepthAction action = DepthAction::Add;
+    Side side = Side::Buy;
+};
+
+struct DepthLevel {
+    Price price = 0;
+    int64_t quantity = 0;
+    uint32_t orderCount = 0;
+};
+
+// Best levels first on each side, as of update `sequence`.
+struct DepthSnapshot {
+    uint64_t sequence = 0;
+    vector<DepthLevel> bids;
+    vector<DepthLevel> asks;
+};
+
+// Preallocated update ring, written under the book's lock. Like EventRing it
+// never blocks the book: updates that do not fit are dropped and counted,
+// and the consumer sees the gap in sequence numbers.
+class DepthRing {
+public:
+    explicit DepthRing(size_t capacity = 1 << 16) : ring_(capacity) {}
+
+    void publish(const DepthUpdate &update) {
+        if(!ring_.push(update))
+            dropped_.fetch_add(1, memory_order_relaxed);
+    }
+
+    bool poll(DepthUpdate &update) { return ring_.pop(update); }
+    bool empty() const { return ring_.empty(); }
+    uint64_t dropped() const { return dropped_.load(memory_order_relaxed); }
+
+private:
+    SpscRing<DepthUpdate> ring_;
+    atomic<uint64_t> dropped_{0};
+};
+
+// Consumer-side depth rebuilt from a snapshot plus increments.
+class DepthBook {
+public:
+    void load(const DepthSnapshot &snapshot) {
+        bids_.clear();
+        asks_.clear();
+        for(const DepthLevel &lvl : snapshot.bids)
+            bids_[lvl.price] = lvl;
+        for(const DepthLevel &lvl : snapshot.asks)
+            asks_[lvl.price] = lvl;
+        sequence_ = snapshot.sequence;
+    }
+
+    // Updates already covered by the snapshot are ignored. Returns false on a
+    // gap (a dropped update); the book must then be reloaded from a snapshot.
+    bool apply(const DepthUpdate &update) {
+        if(update.sequence <= sequence_)
+            return true;
+        if(update.sequence != sequence_ + 1)
+            return false;
+        sequence_ = update.sequence;
+        if(update.action == DepthAction::Clear) {
+            bids_.clear();
+            asks_.clear();
+        } else if(update.side == Side::Buy) {
+            applyTo(bids_, update);
+        } else {
+            applyTo(asks_, update);
+        }
+        return true;
+    }
+
+    uint64_t sequence() const { return sequence_; }
+    size_t bidLevels() const { return bids_.size(); }
+    size_t askLevels() const { return asks_.size(); }
+
+    // The best `depth` levels of each side.
+    DepthSnapshot top(size_t depth) const {
+        DepthSnapshot out;
+        out.sequence = sequence_;
+        copyTop(bids_, depth, out.bids);
+        copyTop(asks_, depth, out.asks);
+        return out;
+    }
+
+private:
+    map<Price, DepthLevel, greater<Price>> bids_;
+    map<Price, DepthLevel, less<Price>> asks_;
+    uint64_t sequence_ = 0;
+
+    template<typename Levels>
+    static void applyTo(Levels &levels, const DepthUpdate &update) {
+        if(update.action == DepthAction::Delete)
+            levels.erase(update.price);
+        else
+            levels[update.price] = DepthLevel{update.price, update.quantity, update.orderCount};
+    }
+
+    template<typename Levels>
+    static void copyTop(const Levels &levels, size_t depth, vector<DepthLevel> &out) {
+        for(auto it = levels.begin(); it != levels.end() && out.size() < depth; ++it)
+            out.push_back(it->second);
+    }
+};
@@ -0,0 +1,206 @@
+#pragma once
+#include "Command.hpp"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+// Append-only binary log of engine commands. The file is a 16-byte header
+// followed by fixed 32-byte records, so replay is a straight walk over a
+// memory-mapped file with no parsing. Appends are buffered and reach the disk
+// in groups: one write() and one fdatasync() per commit(), however many
+// records it carries. POSIX only.
+
+struct JournalHeader {
+    char magic[8] = {'O', 'B', 'J', 'R', 'N', 'L', '0', '1'};
+    uint32_t version = 1;
+    uint32_t recordSize = 32;
+};
+
+struct JournalRecord {
+    uint64_t sequence = 0;  // the command's engine sequence number
+    uint32_t symbol = 0;
+    int32_t orderId = 0;
+    int32_t quantity = 0;
+    CommandType type = CommandType::Add;
+    OrderType orderType = OrderType::Limit;
+    uint8_t buy = 0;
+    uint8_t reserved = 0;
+    double price = 0.0;
+
+    static JournalRecord from(uint64_t sequence, const Command &c) {
+        JournalRecord r;
+        r.sequence = sequence;
+        r.symbol = c.symbol;
+        r.orderId = c.orderId;
+        r.quantity = c.quantity;
+        r.type = c.type;
+        r.orderType = c.orderType;
+        r.buy = c.buy;
+        r.price = c.price;
+        return r;
+    }
+
+    Command command() const {
+        Command c;
+        c.type = type;
+        c.symbol = symbol;
+        c.orderType = orderType;
+        c.buy = buy != 0;
+        c.orderId = orderId;
+        c.quantity = quantity;
+        c.price = price;
+        return c;
+    }
+};
+
+static_assert(sizeof(JournalHeader) == 16, "journal header layout");
+static_assert(sizeof(JournalRecord) == 32, "journal record layout");
+
+class Journal {
+public:
+    Journal() = default;
+    ~Journal() { close(); }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Opens (creating if needed) `path` for appending. A torn record left by
+    // a crash mid-write is cut off. With `sync` false, commit() stops at the
+    // page cache. Returns false if the file cannot be opened or is not a journal.
+    bool open(const string &path, bool sync = true) {
+        close();
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd_ < 0)
+            return false;
+        sync_ = sync;
+        struct stat st;
+        if(fstat(fd_, &st) != 0) {
+            close();
+            return false;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if(size == 0) {
+            JournalHeader header;
+            if(::write(fd_, &header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+                close();
+                return false;
+            }
+            size = sizeof(header);
+        } else {
+            JournalHeader header, expected;
+            if(size < sizeof(header) || ::pread(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+               memcmp(&header, &expected, sizeof(header)) != 0) {
+                close();
+                return false;
+            }
+            size_t whole = sizeof(header) + (size - sizeof(header)) / sizeof(JournalRecord) * sizeof(JournalRecord);
+            if(whole != size && ftruncate(fd_, static_cast<off_t>(whole)) != 0) {
+                close();
+                return false;
+            }
+            size = whole;
+        }
+        lseek(fd_, static_cast<off_t>(size), SEEK_SET);
+        return true;
+    }
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Buffers a record; nothing is durable until commit().
+    void append(uint64_t sequence, const Command &command) {
+        buffer_.push_back(JournalRecord::from(sequence, command));
+    }
+
+    // Drops buffered records, e.g. after a failed commit() that must not be retried.
+    void discard() { buffer_.clear(); }
+
+    size_t pending() const { return buffer_.size(); }
+    uint64_t committed() const { return committed_; }
+
+    // Writes every buffered record and syncs once. Returns false on an I/O error.
+    bool commit() {
+        if(buffer_.empty())
+            return true;
+        if(fd_ < 0)
+            return false;
+        const char *data = reinterpret_cast<const char*>(buffer_.data());
+        size_t left = buffer_.size() * sizeof(JournalRecord);
+        while(left > 0) {
+            ssize_t n = ::write(fd_, data, left);
+            if(n <= 0)
+                return false;
+            data += n;
+            left -= static_cast<size_t>(n);
+        }
+        if(sync_ && fdatasync(fd_) != 0)
+            return false;
+        committed_ += buffer_.size();
+        buffer_.clear();
+        return true;
+    }
+
+    void close() {
+        if(fd_ < 0)
+            return;
+        commit();
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    // Maps `path` and calls f(const JournalRecord&) for each whole record in
+    // order, stopping early at a record whose sequence does not increase.
+    // Records up to sequence `after` (e.g. covered by a snapshot) are skipped
+    // by binary search. A missing file is an empty journal. Returns the
+    // number of records replayed, or -1 if the file is not a journal.
+    template<typename F>
+    static long long replay(const string &path, F &&f, uint64_t after = 0) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return 0;
+        struct stat st;
+        if(fstat(fd, &st) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if(size == 0) {
+            ::close(fd);
+            return 0;
+        }
+        void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(map == MAP_FAILED)
+            return -1;
+        long long count = -1;
+        JournalHeader expected;
+        if(size >= sizeof(JournalHeader) && memcmp(map, &expected, sizeof(expected)) == 0) {
+            madvise(map, size, MADV_SEQUENTIAL);
+            const JournalRecord *records = reinterpret_cast<const JournalRecord*>(
+                static_cast<const char*>(map) + sizeof(JournalHeader));
+            size_t n = (size - sizeof(JournalHeader)) / sizeof(JournalRecord);
+            size_t first = lower_bound(records, records + n, after + 1,
+                [](const JournalRecord &r, uint64_t seq) { return r.sequence < seq; }) - records;
+            uint64_t last = after;
+            count = 0;
+            for(size_t i = first; i < n && records[i].sequence > last; ++i, ++count) {
+                last = records[i].sequence;
+                f(records[i]);
+            }
+        }
+        munmap(map, size);
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+    bool sync_ = true;
+    vector<JournalRecord> buffer_;
+    uint64_t committed_ = 0;
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+using namespace std;
+
+// Log-bucketed latency histogram in the style of HdrHistogram. Values (in
+// nanoseconds) below 256 are counted exactly; above that each power-of-two
+// range is split into 128 sub-buckets, bounding the relative error at 0.8%.
+// Memory is fixed (~60 KB) regardless of sample count. record() and merge()
+// are lock-free, so threads can share one histogram or keep their own and
+// merge them at the end.
+class LatencyHistogram {
+public:
+    static constexpr unsigned subBucketBits = 8;
+    static constexpr uint64_t subBucketCount = uint64_t(1) << subBucketBits;
+    static constexpr uint64_t halfCount = subBucketCount / 2;
+    static constexpr size_t bucketCount = subBucketCount + (64 - subBucketBits) * halfCount;
+
+    LatencyHistogram() { reset(); }
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value) {
+        counts_[indexOf(value)].fetch_add(1, memory_order_relaxed);
+        total_.fetch_add(1, memory_order_relaxed);
+        sum_.fetch_add(value, memory_order_relaxed);
+        updateMin(value);
+        updateMax(value);
+    }
+
+    void merge(const LatencyHistogram &other) {
+        for(size_t i = 0; i < bucketCount; ++i) {
+            uint64_t c = other.counts_[i].load(memory_order_relaxed);
+            if(c)
+                counts_[i].fetch_add(c, memory_order_relaxed);
+        }
+        uint64_t n = other.count();
+        if(n == 0)
+            return;
+        total_.fetch_add(n, memory_order_relaxed);
+        sum_.fetch_add(other.sum_.load(memory_order_relaxed), memory_order_relaxed);
+        updateMin(other.min());
+        updateMax(other.max());
+    }
+
+    void reset() {
+        for(auto &c : counts_)
+            c.store(0, memory_order_relaxed);
+        total_.store(0, memory_order_relaxed);
+        sum_.store(0, memory_order_relaxed);
+        min_.store(numeric_limits<uint64_t>::max(), memory_order_relaxed);
+        max_.store(0, memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total_.load(memory_order_relaxed); }
+    uint64_t max() const { return max_.load(memory_order_relaxed); }
+    uint64_t min() const { return count() ? min_.load(memory_order_relaxed) : 0; }
+    double mean() const {
+        uint64_t n = count();
+        return n ? static_cast<double>(sum_.load(memory_order_relaxed)) / n : 0.0;
+    }
+
+    // Smallest recorded value v such that `percentile`% of samples are <= v,
+    // reported as the top of v's bucket (and never above the true max).
+    uint64_t percentile(double percentile) const {
+        uint64_t n = count();
+        if(n == 0)
+            return 0;
+        uint64_t target = static_cast<uint64_t>(percentile / 100.0 * n + 0.5);
+        if(target < 1) target = 1;
+        if(target > n) target = n;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < bucketCount; ++i) {
+            seen += counts_[i].load(memory_order_relaxed);
+            if(seen >= target) {
+                uint64_t top = highestEquivalent(i);
+                return top < max() ? top : max();
+            }
+        }
+        return max();
+    }
+
+    // One-line summary: count, mean and p50/p90/p99/p99.9/p99.99/max in ns.
+    void print(ostream &out, const char *label) const {
+        out << "[" << label << "] #Samples=" << count()
+            << ", Avg=" << mean() << " ns"
+            << ", p50=" << percentile(50) << " ns"
+            << ", p90=" << percentile(90) << " ns"
+            << ", p99=" << percentile(99) << " ns"
+            << ", p99.9=" << percentile(99.9) << " ns"
+            << ", p99.99=" << percentile(99.99) << " ns"
+            << ", max=" << max() << " ns\n";
+    }
+
+private:
+    array<atomic<uint64_t>, bucketCount> counts_;
+    atomic<uint64_t> total_{0};
+    atomic<uint64_t> sum_{0};
+    atomic<uint64_t> min_{numeric_limits<uint64_t>::max()};
+    atomic<uint64_t> max_{0};
+
+    static size_t indexOf(uint64_t value) {
+        if(value < subBucketCount)
+            return static_cast<size_t>(value);
+        unsigned msb = 63 - __builtin_clzll(value);
+        unsigned shift = msb - subBucketBits + 1;
+        uint64_t top = value >> shift;  // in [halfCount, subBucketCount)
+        return static_cast<size_t>(subBucketCount + (shift - 1) * halfCount + (top - halfCount));
+    }
+
+    static uint64_t highestEquivalent(size_t index) {
+        if(index < subBucketCount)
+            return index;
+        size_t offset = index - subBucketCount;
+        unsigned shift = static_cast<unsigned>(offset / halfCount) + 1;
+        uint64_t top = halfCount + offset % halfCount;
+        return ((top + 1) << shift) - 1;
+    }
+
+    void updateMin(uint64_t value) {
+        uint64_t cur = min_.load(memory_order_relaxed);
+        while(value < cur && !min_.compare_exchange_weak(cur, value, memory_order_relaxed)) {}
+    }
+
+    void updateMax(uint64_t value) {
+        uint64_t cur = max_.load(memory_order_relaxed);
+        while(value > cur && !max_.compare_exchange_weak(cur, value, memory_order_relaxed)) {}
+    }
+};
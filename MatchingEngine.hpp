@@ -0,0 +1,260 @@
+#pragma once
+#include "OrderBook.hpp"
+#include "Command.hpp"
+#include "Journal.hpp"
+#include "Snapshot.hpp"
+#include "Ring.hpp"
+#include "WaitStrategy.hpp"
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+// Single-writer engine mode: producers push commands into an inbound ring and
+// one matching thread owns the book outright (no locks), applying commands in
+// ring order and reporting each outcome through an outbound ring.
+//
+// With a journal configured, every command is appended to it (a rejected one
+// is rejected again on replay, so its sequence number is never reissued) and
+// results are held back until the group they belong to has been synced, so a
+// result is only ever reported for a command that would survive a crash. If a
+// group cannot be made durable the engine stops matching and withholds it.
+// With a snapshot path as well, the matching thread periodically copies the
+// book and a background thread writes the copy; start() then loads the latest
+// snapshot and replays only the journal records after it.
+
+struct MatchingEngineConfig {
+    size_t inboundCapacity = 1 << 16;
+    size_t outboundCapacity = 1 << 16;
+    int cpu = -1;   // core to pin the matching thread to, -1 to leave it unpinned
+    WaitMode waitMode = WaitMode::BusySpin;  // how the matching thread idles on an empty ring
+    string journalPath;         // write-ahead journal, replayed by start(); empty for none
+    size_t groupCommit = 64;    // results per journal sync (fewer whenever the inbound ring runs dry)
+    bool journalSync = true;    // fdatasync each group; false leaves durability to the OS
+    string snapshotPath;        // book snapshot, loaded by start(); empty for none
+    uint64_t snapshotInterval = 0;  // commands between snapshots, 0 to never write one
+};
+
+// Pins the calling thread to `cpu` (no-op for cpu < 0 or off Linux).
+inline void pinCurrentThread(int cpu) {
+#ifdef __linux__
+    if(cpu < 0)
+        return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+template<typename Levels = MapPriceLevels>
+class BasicMatchingEngine {
+public:
+    using Book = BasicOrderBook<Levels, NullMutex>;
+
+    explicit BasicMatchingEngine(const MatchingEngineConfig &config = {}, const PriceScale &scale = {},
+                                 const typename Levels::Config &levels = {},
+                                 const OrderPoolConfig &poolConfig = {})
+        : config_(config), book_(scale, levels, poolConfig),
+          inbound_(config.inboundCapacity), outbound_(config.outboundCapacity), wait_(config.waitMode),
+          snapshotWriter_(config.snapshotPath) {}
+
+    ~BasicMatchingEngine() { stop(); }
+
+    BasicMatchingEngine(const BasicMatchingEngine&) = delete;
+    BasicMatchingEngine& operator=(const BasicMatchingEngine&) = delete;
+
+    // On first start with a journal configured, rebuilds the book from the
+    // snapshot (if any) plus the journal records after it, and opens the
+    // journal for appending. Returns false if either file is unreadable.
+    bool start() {
+        if(!config_.journalPath.empty() && !journal_.isOpen() && !recover())
+            return false;
+        if(snapshotsEnabled())
+            snapshotWriter_.start();
+        running_ = true;
+        thread_ = thread(&BasicMatchingEngine::run, this);
+        return true;
+    }
+
+    // Applies every command already submitted, then joins the matching thread.
+    void stop() {
+        running_ = false;
+        wait_.notify();
+        if(thread_.joinable())
+            thread_.join();
+        snapshotWriter_.stop();
+    }
+
+    // Safe from any number of threads. Returns false if the inbound ring is
+    // full or the engine has failed.
+    bool submit(const Command &command) {
+        if(failed() || !inbound_.push(command))
+            return false;
+        wait_.notify();
+        return true;
+    }
+
+    // Single consumer. Results must be drained, or the matching thread stalls
+    // once the outbound ring fills.
+    bool pollResult(CommandResult &result) { return outbound_.pop(result); }
+
+    // Direct access to the book; only safe while the engine is stopped.
+    Book& book() { return book_; }
+
+    uint64_t processed() const { return sequence_.load(memory_order_acquire); }
+
+    // Commands replayed from the journal by start().
+    uint64_t recovered() const { return recovered_; }
+
+    // Sequence of the snapshot start() loaded, 0 if none.
+    uint64_t snapshotSequence() const { return snapshotSequence_; }
+
+    uint64_t snapshotsWritten() const { return snapshotWriter_.written(); }
+
+    // Journal groups that failed to write or sync (their results were withheld).
+    uint64_t journalErrors() const { return journalErrors_.load(memory_order_relaxed); }
+
+    // True once a journal group failed: the matching thread has stopped and
+    // commands applied since the last durable group got no result.
+    bool failed() const { return failed_.load(memory_order_acquire); }
+
+private:
+    MatchingEngineConfig config_;
+    Book book_;
+    MpscRing<Command> inbound_;
+    SpscRing<CommandResult> outbound_;
+    WaitStrategy wait_;
+    atomic<bool> running_{false};
+    atomic<uint64_t> sequence_{0};
+    thread thread_;
+
+    Journal journal_;
+    vector<CommandResult> held_;    // results waiting for their journal group to commit
+    uint64_t recovered_ = 0;
+    atomic<uint64_t> journalErrors_{0};
+    atomic<bool> failed_{false};
+
+    SnapshotWriter snapshotWriter_;
+    uint64_t snapshotSequence_ = 0;
+    uint64_t nextSnapshot_ = 0;
+
+    bool snapshotsEnabled() const {
+        return !config_.snapshotPath.empty() && !config_.journalPath.empty() && config_.snapshotInterval > 0;
+    }
+
+    bool recover() {
+        if(!config_.snapshotPath.empty() && access(config_.snapshotPath.c_str(), F_OK) == 0) {
+            MappedSnapshot snapshot;
+            if(!snapshot.open(config_.snapshotPath) ||
+               !book_.restoreSnapshot(snapshot.header(), snapshot.entries()))
+                return false;
+            snapshotSequence_ = snapshot.header().sequence;
+            sequence_.store(snapshotSequence_, memory_order_release);
+        }
+        uint64_t last = sequence_.load(memory_order_relaxed);
+        long long replayed = Journal::replay(config_.journalPath, [this, &last](const JournalRecord &record) {
+            applyCommand(book_, record.command());
+            last = record.sequence;
+        }, last);
+        if(replayed < 0)
+            return false;
+        recovered_ = static_cast<uint64_t>(replayed);
+        sequence_.store(last, memory_order_release);
+        held_.reserve(config_.groupCommit);
+        nextSnapshot_ = last + config_.snapshotInterval;
+        return journal_.open(config_.journalPath, config_.journalSync);
+    }
+
+    void run() {
+        pinCurrentThread(config_.cpu);
+        Command command;
+        unsigned spins = 0;
+        auto ready = [this]{ return !inbound_.empty() || !running_; };
+        for(;;) {
+            // Sampled before the poll: a journal sync can outlast the last
+            // submit and stop(), and those commands must still be applied.
+            bool stopping = !running_;
+            if(inbound_.pop(command)) {
+                apply(command);
+                spins = 0;
+                if(held_.size() >= config_.groupCommit && !commitGroup())
+                    break;
+                if(snapshotsEnabled() && sequence_.load(memory_order_relaxed) >= nextSnapshot_ && !takeSnapshot())
+                    break;
+            } else {
+                if(!commitGroup() || stopping)
+                    break;
+                wait_.idle(spins, ready);
+            }
+        }
+    }
+
+    void apply(const Command &command) {
+        CommandResult result;
+        result.symbol = command.symbol;
+        result.type = command.type;
+        result.orderId = command.orderId;
+        result.accepted = applyCommand(book_, command);
+        result.sequence = sequence_.load(memory_order_relaxed) + 1;
+        sequence_.store(result.sequence, memory_order_release);
+        if(journal_.isOpen()) {
+            journal_.append(result.sequence, command);
+            held_.push_back(result);
+        } else {
+            publish(result);
+        }
+    }
+
+    // Makes the held group durable with one sync, then releases its results.
+    // A failed write or sync is not retried (the kernel may already have
+    // dropped the dirty pages): the group is withheld and the engine fails.
+    bool commitGroup() {
+        if(held_.empty())
+            return true;
+        if(!journal_.commit()) {
+            journalErrors_.fetch_add(1, memory_order_relaxed);
+            journal_.discard();
+            held_.clear();
+            failed_.store(true, memory_order_release);
+            return false;
+        }
+        for(const CommandResult &result : held_)
+            publish(result);
+        held_.clear();
+        return true;
+    }
+
+    // Copies the book for the background writer once everything it reflects
+    // is in the journal. If the previous snapshot is still being written,
+    // tries again after the next command. Returns false if the commit failed.
+    bool takeSnapshot() {
+        if(snapshotWriter_.busy())
+            return true;
+        if(!commitGroup())
+            return false;
+        uint64_t sequence = sequence_.load(memory_order_relaxed);
+        BookSnapshot snapshot;
+        book_.captureSnapshot(snapshot);
+        snapshot.header.sequence = sequence;
+        snapshotWriter_.submit(move(snapshot));
+        nextSnapshot_ = sequence + config_.snapshotInterval;
+        return true;
+    }
+
+    void publish(const CommandResult &result) {
+        // Back-pressure on the result consumer, but never hang a stopping engine.
+        while(!outbound_.push(result) && running_)
+            cpuRelax();
+    }
+};
+
+using MatchingEngine = BasicMatchingEngine<MapPriceLevels>;
@@ -0,0 +1,124 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+using namespace std;
+
+// Prices inside the book are integer ticks; PriceScale converts to and from
+// doubles at the API edge.
+using Price = int64_t;
+
+struct PriceScale {
+    double tickSize = 0.01;
+
+    Price toTicks(double price) const { return llround(price / tickSize); }
+    double toDouble(Price ticks) const { return ticks * tickSize; }
+};
+
+enum class OrderType : uint8_t { Market, Limit, Stop, IOC };
+
+enum class Side : uint8_t { Buy, Sell };
+
+// Compatibility with the string API: "buy" is a buy, anything else a sell.
+inline Side toSide(const string &side) { return side == "buy" ? Side::Buy : Side::Sell; }
+inline const char* sideName(Side side) { return side == Side::Buy ? "buy" : "sell"; }
+
+struct PriceLevel;
+
+// One order record per cache line, trivially copyable so the pool can reset
+// and copy slots with plain stores. Fields are ordered by size to avoid padding.
+struct alignas(64) Order {
+    Price price = 0;
+    Price stopPrice = 0;        // trigger, for stop orders
+    // Intrusive links into the resting level; level is null when not resting.
+    Order *prev = nullptr;
+    Order *next = nullptr;
+    PriceLevel *level = nullptr;
+    uint64_t timestamp = 0;     // arrival stamp assigned by the book when the order rests
+    int orderId = 0;
+    int quantity = 0;
+    // Bumped by OrderPool each time the slot is recycled.
+    uint32_t generation = 0;
+    OrderType orderType = OrderType::Limit;
+    Side side = Side::Buy;
+
+    Order() = default;
+    Order(OrderType type, int id, Price px, int qty, Side s, Price stop = 0)
+        : price(px), stopPrice(stop), orderId(id), quantity(qty), orderType(type), side(s) {}
+};
+
+static_assert(sizeof(Order) == 64, "Order should occupy exactly one cache line");
+static_assert(is_trivially_copyable<Order>::value, "Order must stay trivially copyable");
+
+using OrderPointer = shared_ptr<Order>;
+
+// FIFO queue of resting orders at one price, linked through the orders
+// themselves so any order can be unlinked in O(1) via its level pointer.
+// Orders are owned elsewhere (the book's active order map).
+struct PriceLevel {
+    Price price = 0;
+    Order *head = nullptr;
+    Order *tail = nullptr;
+    size_t count = 0;
+    int64_t quantity = 0;   // sum of the resting orders' open quantity
+
+    bool empty() const { return head == nullptr; }
+    Order* front() const { return head; }
+
+    void push_back(Order *order) {
+        order->prev = tail;
+        order->next = nullptr;
+        order->level = this;
+        if(tail) tail->next = order;
+        else head = order;
+        tail = order;
+        ++count;
+        quantity += order->quantity;
+    }
+
+    void erase(Order *order) {
+        if(order->prev) order->prev->next = order->next;
+        else head = order->next;
+        if(order->next) order->next->prev = order->prev;
+        else tail = order->prev;
+        order->prev = order->next = nullptr;
+        order->level = nullptr;
+        --count;
+        quantity -= order->quantity;
+    }
+
+    void pop_front() { erase(head); }
+
+    // Reduces a resting order's open quantity, keeping the level total in step.
+    static void reduce(Order *order, int amount) {
+        order->quantity -= amount;
+        if(order->level)
+            order->level->quantity -= amount;
+    }
+
+    // Detaches every order front to back, calling f(order) on each once it
+    // is unlinked, and leaves the level empty. One pass, with no per-order
+    // relinking or total updates.
+    template<typename F>
+    void drain(F &&f) {
+        Order *order = head;
+        head = tail = nullptr;
+        count = 0;
+        quantity = 0;
+        while(order) {
+            Order *next = order->next;
+            order->prev = order->next = nullptr;
+            order->level = nullptr;
+            f(order);
+            order = next;
+        }
+    }
+
+    // Detaches every order without touching ownership.
+    void clear() {
+        while(head)
+            pop_front();
+    }
+};
@@ -14,322 +14,991 @@
 #include <limits>
 #include <unordered_map>
 #include <functional>
+#include "Order.hpp"
+#include "PriceLevels.hpp"
+#include "OrderPool.hpp"
+#include "OrderIndex.hpp"
+#include "StopBook.hpp"
+#include "WaitStrategy.hpp"
+#include "BookEvents.hpp"
+#include "BookListener.hpp"
+#include "Seqlock.hpp"
+#include "Snapshot.hpp"
+#include "DepthFeed.hpp"
+#include "OrderFeed.hpp"
+#include "ConflatingPublisher.hpp"
 using namespace std;
 
-enum class OrderType { Market, Limit, Stop, IOC };
+// use the tbb concurrent queue
+#include <tbb/concurrent_queue.h>
 
-struct Order {
-    OrderType orderType;
-    int orderId;
-    double price;
-    int quantity;
-    string side; // "buy" or "sell"
-    double stopPrice = 0.0; // For stop orders, if needed
+// One item of a batch call (addOrders / modifyOrders).
+struct OrderRequest {
+    int orderId = 0;
+    double price = 0.0;
+    int quantity = 0;
+    Side side = Side::Buy;
+    OrderType orderType = OrderType::Limit;
 };
 
-using OrderPointer = shared_ptr<Order>;
-using OrderList = list<OrderPointer>;
-
-// Use TBB's concurrent_hash_map with an explicit hash compare type.
-#include <tbb/concurrent_hash_map.h>
-using ActiveOrdersMap = tbb::concurrent_hash_map<int, OrderPointer, tbb::tbb_hash_compare<int>>;
+struct ModifyRequest {
+    int orderId = 0;
+    int newQuantity = 0;
+    double newPrice = 0.0;
+};
 
-// use the tbb concurrent queue
-#include <tbb/concurrent_queue.h>
+// Lock type for a book owned by a single thread (see MatchingEngine.hpp).
+struct NullMutex {
+    void lock() {}
+    void unlock() {}
+};
 
-class OrderBook {
+// Levels selects the price level storage (see PriceLevels.hpp). A book
+// instantiated with NullMutex is single-writer: limit orders are matched on
+// arrival by the calling thread instead of being queued for the processors.
+// Listener receives fills, order updates and top-of-book changes through
+// statically bound calls (see BookListener.hpp).
+template<typename Levels, typename Mutex = mutex, typename Listener = NullBookListener>
+class BasicOrderBook {
 private:
+    static constexpr bool singleWriter = is_same<Mutex, NullMutex>::value;
+    static constexpr bool hasListener = !is_same<Listener, NullBookListener>::value;
+
+    using BuySide = typename Levels::template Side<true>;
+    using SellSide = typename Levels::template Side<false>;
+
     // Buy orders ordered by price descending; Sell orders ordered by price ascending.
-    map<double, OrderList, greater<double>> buyOrders_;
-    map<double, OrderList> sellOrders_;
-    
-    // Use TBB's concurrent_hash_map for order tracking.
-    ActiveOrdersMap activeOrders_;
+    BuySide buyOrders_;
+    SellSide sellOrders_;
+
+    // Tick size used to convert prices at the API edge.
+    PriceScale scale_;
+
+    // Resting orders live in the pool; activeOrders_ maps IDs to their slots.
+    OrderPool pool_;
+
+    // Every access already holds mtx_, so a plain slab/hash index suffices.
+    OrderIndex activeOrders_;
 
     // Mutex for protecting order book operations.
-    mutex mtx_;
+    Mutex mtx_;
     atomic<bool> running_{true};
-    
+
     // Queues for asynchronous processing.
-    tbb::concurrent_queue<OrderPointer> buyQueue_;
-    tbb::concurrent_queue<OrderPointer> sellQueue_;
-    
-    // Matching function for buy orders.
-    void matchBuyOrder(OrderPointer buyOrder) {
-        lock_guard<mutex> lock(mtx_);
-        // For market orders, we ignore price checks.
-        while(buyOrder->quantity > 0 && !sellOrders_.empty() &&
-             (buyOrder->orderType == OrderType::Market || sellOrders_.begin()->first <= buyOrder->price)) {
-            double bestAsk = sellOrders_.begin()->first;
-            auto &sellList = sellOrders_.begin()->second;
-            OrderPointer sellOrder = sellList.front();
-            // If the sell order is already zero, remove it.
-            if(sellOrder->quantity <= 0) {
-                sellList.pop_front();
-                if(sellList.empty())
-                    sellOrders_.erase(bestAsk);
+    tbb::concurrent_queue<OrderHandle> buyQueue_;
+    tbb::concurrent_queue<OrderHandle> sellQueue_;
+
+    // How processBuyOrders/processSellOrders idle when their queue is empty.
+    WaitStrategy buyWait_;
+    WaitStrategy sellWait_;
+
+    // Set while a batch call holds mtx_; queued sides are woken when it ends.
+    bool batching_ = false;
+    bool buyQueued_ = false;
+    bool sellQueued_ = false;
+
+    // Optional event output; written under mtx_, so a single ring suffices.
+    EventRing *events_ = nullptr;
+    uint64_t eventSequence_ = 0;
+
+    // Optional L2 output: levels touched by the current mutation, published
+    // as one DepthUpdate each and/or folded into the conflated view by
+    // publishDepth(). Written under mtx_.
+    struct DirtyLevel {
+        Price price;
+        bool bid;
+        bool known;     // the level was non-empty (so already published) when first touched
+    };
+    DepthRing *depth_ = nullptr;
+    uint64_t depthSequence_ = 0;
+    vector<DirtyLevel> dirtyLevels_;
+    ConflatingPublisher *conflated_ = nullptr;
+    DepthView view_;    // last view handed to conflated_
+
+    // Optional L3 output. On a single-writer book a new or modified order is
+    // matched before it is announced, so its Add/Replace waits in pending_
+    // until matching is done (and becomes nothing, or a Delete, if it filled).
+    struct PendingAnnounce {
+        int orderId = 0;
+        Side side = Side::Buy;
+        Price price = 0;
+        OrderFeedType type = OrderFeedType::Add;
+        bool active = false;
+    };
+    OrderFeedRing *feed_ = nullptr;
+    uint64_t feedSequence_ = 0;
+    PendingAnnounce pending_;
+
+    // Source of Order::timestamp.
+    uint64_t arrivals_ = 0;
+
+    Listener listener_;
+    TopOfBook lastTop_;
+
+    // Touch published for readers that must not take mtx_; written under it.
+    Seqlock<TopOfBookSnapshot> quote_;
+    uint64_t quoteSequence_ = 0;
+
+    // Resting stop orders and the last trade price they are checked against.
+    StopBook stops_;
+    Price lastTradePrice_ = 0;
+    bool traded_ = false;
+    vector<StopOrder> elected_;
+
+    // Stamps and publishes an event. Caller holds mtx_.
+    void emit(BookEvent event) {
+        if(events_ == nullptr && !hasListener)
+            return;
+        event.sequence = ++eventSequence_;
+        if(events_ != nullptr)
+            events_->publish(event);
+        if(event.type == EventType::Fill)
+            listener_.onFill(event);
+        else
+            listener_.onOrderUpdate(event);
+    }
+
+    TopOfBook currentTop() {
+        TopOfBook top;
+        if(!buyOrders_.empty()) {
+            top.bidPrice = buyOrders_.bestPrice();
+            top.bidQuantity = buyOrders_.bestLevel().quantity;
+            top.hasBid = true;
+        }
+        if(!sellOrders_.empty()) {
+            top.askPrice = sellOrders_.bestPrice();
+            top.askQuantity = sellOrders_.bestLevel().quantity;
+            top.hasAsk = true;
+        }
+        return top;
+    }
+
+    // Called at the end of every mutation; if the touch moved, republishes
+    // the lock-free snapshot and notifies the listener. Caller holds mtx_.
+    void publishTopOfBook() {
+        TopOfBook top = currentTop();
+        if(top != lastTop_) {
+            lastTop_ = top;
+            quote_.write(TopOfBookSnapshot{top, ++quoteSequence_});
+            listener_.onTopOfBook(top);
+        }
+    }
+
+    // Records that `lvl` is about to change; call before modifying it.
+    // Caller holds mtx_.
+    void markLevel(bool bid, const PriceLevel &lvl) {
+        if(depth_ == nullptr && conflated_ == nullptr)
+            return;
+        if(!dirtyLevels_.empty() && dirtyLevels_.back().price == lvl.price && dirtyLevels_.back().bid == bid)
+            return;
+        dirtyLevels_.push_back(DirtyLevel{lvl.price, bid, !lvl.empty()});
+    }
+
+    template<typename Side>
+    void publishLevel(Side &levels, const DirtyLevel &dirty) {
+        DepthUpdate update;
+        update.price = dirty.price;
+        update.side = dirty.bid ? ::Side::Buy : ::Side::Sell;
+        if(const PriceLevel *lvl = levels.find(dirty.price)) {
+            update.action = dirty.known ? DepthAction::Change : DepthAction::Add;
+            update.quantity = lvl->quantity;
+            update.orderCount = static_cast<uint32_t>(lvl->count);
+        } else if(dirty.known) {
+            update.action = DepthAction::Delete;
+        } else {
+            return; // appeared and emptied within one mutation
+        }
+        update.sequence = ++depthSequence_;
+        depth_->publish(update);
+    }
+
+    // True if a change at `dirty` can alter the published view: the level is
+    // in it, or better than its worst level, or that side is not full.
+    bool inView(const DirtyLevel &dirty) const {
+        if(dirty.bid)
+            return view_.bidCount < depthViewLevels || dirty.price >= view_.bids[view_.bidCount - 1].price;
+        return view_.askCount < depthViewLevels || dirty.price <= view_.asks[view_.askCount - 1].price;
+    }
+
+    // Rebuilds the best levels and hands them to conflated_. Caller holds mtx_.
+    void publishView() {
+        view_.bidCount = 0;
+        view_.askCount = 0;
+        buyOrders_.forBestLevels(depthViewLevels, [this](Price price, const PriceLevel &lvl) {
+            view_.bids[view_.bidCount++] = DepthLevel{price, lvl.quantity, static_cast<uint32_t>(lvl.count)};
+        });
+        sellOrders_.forBestLevels(depthViewLevels, [this](Price price, const PriceLevel &lvl) {
+            view_.asks[view_.askCount++] = DepthLevel{price, lvl.quantity, static_cast<uint32_t>(lvl.count)};
+        });
+        conflated_->publish(view_);
+    }
+
+    // Publishes the final state of every level the mutation touched, once
+    // each (a level touched twice keeps its first "known"), and refreshes
+    // the conflated view if any of them can show in it. Caller holds mtx_.
+    void publishDepth() {
+        if(dirtyLevels_.empty())
+            return;
+        bool viewChanged = false;
+        stable_sort(dirtyLevels_.begin(), dirtyLevels_.end(), [](const DirtyLevel &a, const DirtyLevel &b) {
+            return a.bid != b.bid ? a.bid : (a.bid ? a.price > b.price : a.price < b.price);
+        });
+        for(size_t i = 0; i < dirtyLevels_.size(); ++i) {
+            const DirtyLevel &dirty = dirtyLevels_[i];
+            if(i > 0 && dirtyLevels_[i - 1].price == dirty.price && dirtyLevels_[i - 1].bid == dirty.bid)
                 continue;
+            if(conflated_ != nullptr && !viewChanged)
+                viewChanged = inView(dirty);
+            if(depth_ == nullptr)
+                continue;
+            if(dirty.bid)
+                publishLevel(buyOrders_, dirty);
+            else
+                publishLevel(sellOrders_, dirty);
+        }
+        dirtyLevels_.clear();
+        if(viewChanged)
+            publishView();
+    }
+
+    // Publishes one L3 message. Caller holds mtx_ and has checked feed_.
+    void announce(OrderFeedType type, int orderId, Side side, Price price, int quantity, int contraOrderId = 0) {
+        OrderMessage message;
+        message.sequence = ++feedSequence_;
+        message.type = type;
+        message.orderId = orderId;
+        message.side = side;
+        message.price = price;
+        message.quantity = quantity;
+        message.contraOrderId = contraOrderId;
+        feed_->publish(message);
+    }
+
+    // Announces a resting order that was just added or modified, now (on a
+    // book whose processors match later) or after matching (single-writer).
+    void announceResting(OrderFeedType type, const Order &order) {
+        if(feed_ == nullptr)
+            return;
+        if(singleWriter)
+            pending_ = PendingAnnounce{order.orderId, order.side, order.price, type, true};
+        else
+            announce(type, order.orderId, order.side, order.price, order.quantity);
+    }
+
+    // Publishes the held announcement once matching has run. Caller holds mtx_.
+    void flushPending() {
+        if(!pending_.active)
+            return;
+        pending_.active = false;
+        if(Order *order = activeOrders_.find(pending_.orderId))
+            announce(pending_.type, order->orderId, order->side, order->price, order->quantity);
+        else if(pending_.type == OrderFeedType::Replace)
+            announce(OrderFeedType::Delete, pending_.orderId, pending_.side, pending_.price, 0);
+    }
+
+    // True if fills of `order` must be reported on the L3 feed.
+    bool announced(const Order &order) const {
+        return order.level != nullptr && !(pending_.active && pending_.orderId == order.orderId);
+    }
+
+    static BookEvent stopEvent(EventType type, const StopOrder &stop) {
+        BookEvent event;
+        event.type = type;
+        event.orderId = stop.orderId;
+        event.orderType = OrderType::Stop;
+        event.buy = stop.buy;
+        event.price = stop.stopPrice;
+        event.quantity = stop.quantity;
+        return event;
+    }
+
+    static BookEvent orderEvent(EventType type, const Order &order, int quantity) {
+        BookEvent event;
+        event.type = type;
+        event.orderId = order.orderId;
+        event.orderType = order.orderType;
+        event.buy = order.side == Side::Buy;
+        event.price = order.price;
+        event.quantity = quantity;
+        return event;
+    }
+
+    void reject(int orderId, bool buy, OrderType orderType, RejectReason reason) {
+        BookEvent event;
+        event.type = EventType::Reject;
+        event.orderId = orderId;
+        event.buy = buy;
+        event.orderType = orderType;
+        event.reason = reason;
+        emit(event);
+    }
+
+    // Unlinks a resting order from its level in O(1), dropping the level if it empties.
+    template<typename Side>
+    void removeFromLevel(Side &levels, Order *order) {
+        PriceLevel *lvl = order->level;
+        if(lvl == nullptr)
+            return;
+        lvl->erase(order);
+        if(lvl->empty())
+            levels.erase(lvl->price);
+    }
+
+    // Removes a filled or cancelled resting order from the ID map and returns its slot to the pool.
+    void retire(Order *order) {
+        activeOrders_.erase(order->orderId);
+        pool_.release(order);
+    }
+
+    // Fills every order at `lvl` (whose total `order` covers) in queue order
+    // and leaves the level empty for the caller to drop. Caller holds mtx_.
+    void consumeLevel(Order *order, PriceLevel &lvl, Price price) {
+        int traded = 0;
+        bool reportOwn = feed_ != nullptr && announced(*order);
+        lvl.drain([&](Order *resting) {
+            int tradeQty = resting->quantity;
+            if(tradeQty > 0) {
+                BookEvent fill = orderEvent(EventType::Fill, *order, tradeQty);
+                fill.contraOrderId = resting->orderId;
+                fill.price = price;
+                emit(fill);
+                if(feed_ != nullptr) {
+                    announce(OrderFeedType::Execute, resting->orderId, resting->side, price, tradeQty, order->orderId);
+                    if(reportOwn)
+                        announce(OrderFeedType::Execute, order->orderId, order->side, price, tradeQty, resting->orderId);
+                }
+                traded += tradeQty;
+            } else if(feed_ != nullptr) {
+                announce(OrderFeedType::Delete, resting->orderId, resting->side, price, 0);
             }
-            int tradeQty = min(buyOrder->quantity, sellOrder->quantity);
-            if(tradeQty <= 0)
-                break;
-            cout << "Trade executed: Buy order " << buyOrder->orderId
-                 << " and Sell order " << sellOrder->orderId
-                 << " for quantity " << tradeQty
-                 << " at price " << bestAsk << "\n";
-            buyOrder->quantity -= tradeQty;
-            sellOrder->quantity -= tradeQty;
-            if(sellOrder->quantity == 0) {
-                // Erase from active orders using key
-                activeOrders_.erase(sellOrder->orderId);
-                sellList.pop_front();
-                if(sellList.empty())
-                    sellOrders_.erase(bestAsk);
+            retire(resting);
+        });
+        if(traded > 0) {
+            PriceLevel::reduce(order, traded);
+            lastTradePrice_ = price;
+            traded_ = true;
+        }
+    }
+
+    // Matches `order` against the opposite side `contra`; `own` is the side the
+    // order rests on (if it is a limit order). Caller holds mtx_.
+    template<typename ContraSide, typename OwnSide>
+    void matchAgainst(Order *order, ContraSide &contra, OwnSide &own) {
+        bool bid = order->side == Side::Buy;
+        if(order->level != nullptr)
+            markLevel(bid, *order->level);
+        const PriceLevel *marked = nullptr;
+        // For market orders, we ignore price checks.
+        while(order->quantity > 0 && !contra.empty() &&
+             (order->orderType == OrderType::Market || contra.crosses(order->price))) {
+            Price bestPrice = contra.bestPrice();
+            PriceLevel &contraLevel = contra.bestLevel();
+            if(&contraLevel != marked) {
+                markLevel(!bid, contraLevel);
+                marked = &contraLevel;
             }
-            if(buyOrder->quantity == 0)
-            {
-                activeOrders_.erase(buyOrder->orderId);
-                double buyPrice=buyOrder->price;
-                auto it=buyOrders_.find(buyPrice);
-                if(it!=buyOrders_.end())
-                {
-                    auto &buyList=it->second;
-                    buyList.remove_if([&](const OrderPointer &o){return o->orderId==buyOrder->orderId;});
-                    if(buyList.empty()) buyOrders_.erase(it);
+            // The level's total says up front whether it is taken out whole;
+            // if so (and it queues several orders), fill it in one pass and drop it.
+            // That is one compare per level, so there is no vectorised prefix
+            // sum here: ladder totals are strided across PriceLevel structs, and
+            // a contiguous copy would cost a store on every add, cancel and fill.
+            if(contraLevel.count > 1 && order->quantity >= contraLevel.quantity) {
+                consumeLevel(order, contraLevel, bestPrice);
+                contra.erase(bestPrice);
+                if(order->quantity == 0 && order->level != nullptr) {
+                    removeFromLevel(own, order);
+                    retire(order);
+                    return;
                 }
+                continue;
+            }
+            Order *resting = contraLevel.front();
+            // If the resting order is already zero, remove it.
+            if(resting->quantity <= 0) {
+                if(feed_ != nullptr)
+                    announce(OrderFeedType::Delete, resting->orderId, resting->side, bestPrice, 0);
+                contraLevel.pop_front();
+                if(contraLevel.empty())
+                    contra.erase(bestPrice);
+                retire(resting);
+                continue;
+            }
+            int tradeQty = min(order->quantity, resting->quantity);
+            BookEvent fill = orderEvent(EventType::Fill, *order, tradeQty);
+            fill.contraOrderId = resting->orderId;
+            fill.price = bestPrice;
+            emit(fill);
+            if(feed_ != nullptr) {
+                announce(OrderFeedType::Execute, resting->orderId, resting->side, bestPrice, tradeQty, order->orderId);
+                if(announced(*order))
+                    announce(OrderFeedType::Execute, order->orderId, order->side, bestPrice, tradeQty, resting->orderId);
+            }
+            lastTradePrice_ = bestPrice;
+            traded_ = true;
+            PriceLevel::reduce(order, tradeQty);
+            PriceLevel::reduce(resting, tradeQty);
+            if(resting->quantity == 0) {
+                contraLevel.pop_front();
+                if(contraLevel.empty())
+                    contra.erase(bestPrice);
+                retire(resting);
+            }
+            // Only resting (pooled) orders are retired; market, IOC and stop orders belong to the caller.
+            if(order->quantity == 0 && order->level != nullptr) {
+                removeFromLevel(own, order);
+                retire(order);
+                return;
             }
         }
     }
-    
+
+    // Matching function for buy orders. A queued order whose slot was recycled
+    // (filled or cancelled meanwhile) has nothing left to match.
+    void matchBuyOrder(OrderHandle buyOrder) {
+        lock_guard<Mutex> lock(mtx_);
+        if(buyOrder.valid()) {
+            matchAgainst(buyOrder.order, sellOrders_, buyOrders_);
+            finishMutation();
+        }
+    }
+
     // Matching function for sell orders.
-    void matchSellOrder(OrderPointer sellOrder) {
-        lock_guard<mutex> lock(mtx_);
-        while(sellOrder->quantity > 0 && !buyOrders_.empty() &&
-             (sellOrder->orderType == OrderType::Market || buyOrders_.begin()->first >= sellOrder->price)) {
-            double bestBid = buyOrders_.begin()->first;
-            auto &buyList = buyOrders_.begin()->second;
-            OrderPointer buyOrder = buyList.front();
-            if(sellOrder->quantity <= 0) {
-                buyList.pop_front();
-                if(buyList.empty()) sellOrders_.erase(bestBid);
-                continue;
+    void matchSellOrder(OrderHandle sellOrder) {
+        lock_guard<Mutex> lock(mtx_);
+        if(sellOrder.valid()) {
+            matchAgainst(sellOrder.order, buyOrders_, sellOrders_);
+            finishMutation();
+        }
+    }
+
+    // Matches an order against the opposite side right away. Caller holds mtx_.
+    void matchNow(Order *order) {
+        if(order->side == Side::Buy)
+            matchAgainst(order, sellOrders_, buyOrders_);
+        else
+            matchAgainst(order, buyOrders_, sellOrders_);
+    }
+
+    // Market/IOC (and activated stop) orders: match, then discard any remainder.
+    // Caller holds mtx_.
+    void executeImmediate(Order *order) {
+        emit(orderEvent(EventType::Accept, *order, order->quantity));
+        matchNow(order);
+        if(order->quantity > 0)
+            emit(orderEvent(EventType::Expired, *order, order->quantity));
+    }
+
+    // Executes the stops crossed by the last trade or the touch as market
+    // orders: buy stops once the best ask or the last trade is at or above the
+    // trigger, sell stops once the best bid or the last trade is at or below
+    // it. Only the crossed stops are visited. Fills from those executions can
+    // cross further stops, so election repeats until the book is quiet. Each
+    // round runs buy stops then sell stops, each side in trigger-price then
+    // arrival order, so a cascade plays out the same way on every run.
+    // Caller holds mtx_.
+    void triggerStops() {
+        while(!stops_.empty()) {
+            elected_.clear();
+            if(stops_.hasBuys() && (traded_ || !sellOrders_.empty())) {
+                Price reference = traded_ ? lastTradePrice_ : sellOrders_.bestPrice();
+                if(!sellOrders_.empty())
+                    reference = max(reference, sellOrders_.bestPrice());
+                stops_.electBuys(reference, elected_);
             }
-            int tradeQty = min(sellOrder->quantity, buyOrder->quantity);
-            if(tradeQty <= 0)   break;
-            cout << "Trade executed: Sell order " << sellOrder->orderId
-                 << " and Buy order " << buyOrder->orderId
-                 << " for quantity " << tradeQty
-                 << " at price " << bestBid << "\n";
-            sellOrder->quantity -= tradeQty;
-            buyOrder->quantity -= tradeQty;
-            if(buyOrder->quantity == 0) {
-                activeOrders_.erase(buyOrder->orderId);
-                buyList.pop_front();
-                if(buyList.empty()) buyOrders_.erase(bestBid);
+            if(stops_.hasSells() && (traded_ || !buyOrders_.empty())) {
+                Price reference = traded_ ? lastTradePrice_ : buyOrders_.bestPrice();
+                if(!buyOrders_.empty())
+                    reference = min(reference, buyOrders_.bestPrice());
+                stops_.electSells(reference, elected_);
             }
-            if(sellOrder->quantity == 0)
-            {
-                activeOrders_.erase(sellOrder->orderId);
-                double sellPrice=sellOrder->price;
-                auto it=sellOrders_.find(sellPrice);
-                if(it!=sellOrders_.end())
-                {
-                    auto &sellList=it->second;
-                    sellList.remove_if([&](const OrderPointer &o){return o->orderId==sellOrder->orderId;});
-                    if(sellList.empty()) sellOrders_.erase(it);
-                }
+            if(elected_.empty())
+                return;
+            for(const StopOrder &stop : elected_) {
+                emit(stopEvent(EventType::Triggered, stop));
+                Order order{OrderType::Market, stop.orderId, stop.stopPrice, stop.quantity,
+                            stop.buy ? Side::Buy : Side::Sell, stop.stopPrice};
+                executeImmediate(&order);
             }
         }
     }
-    
-public:
-    // Clears the order book.
-    inline void reset() {
-        lock_guard<mutex> lock(mtx_);
+
+    // Drops every resting order and stop. Caller holds mtx_.
+    void clearState() {
+        pending_.active = false;
+        if(feed_ != nullptr)
+            announce(OrderFeedType::Clear, 0, Side::Buy, 0, 0);
+        if(depth_ != nullptr) {
+            dirtyLevels_.clear();
+            DepthUpdate update;
+            update.action = DepthAction::Clear;
+            update.sequence = ++depthSequence_;
+            depth_->publish(update);
+        }
         buyOrders_.clear();
         sellOrders_.clear();
+        activeOrders_.forEach([this](Order *order) { pool_.release(order); });
         activeOrders_.clear();
-        cout << "[OrderBook] reset\n";
+        stops_.clear();
+        traded_ = false;
+        if(conflated_ != nullptr) {
+            dirtyLevels_.clear();
+            publishView();
+        }
     }
-    
-    // Add an order to the book.
-    inline void addOrder(int orderId, double price, int quantity, 
-                         const string& side, OrderType orderType)
-    {
-        OrderPointer order = make_shared<Order>(Order{orderType, orderId, price, quantity, side});
-        if(orderType == OrderType::Market) {
-            // Process market orders immediately.
-            processOrder(order);
-            cout << "[OrderBook] Market order processed immediately -> ID=" << orderId
-                 << ", side=" << side << "\n";
-            return;
+
+    // Called at the end of every mutation. Caller holds mtx_.
+    void finishMutation() {
+        triggerStops();
+        publishDepth();
+        publishTopOfBook();
+    }
+
+    // Hands a newly rested order to the processor threads, or matches it right
+    // away on a single-writer book. Inside a batch the processors are woken
+    // once at the end instead. Caller holds mtx_; `order` may be retired.
+    void enqueueForMatching(Order *order) {
+        if(singleWriter) {
+            matchNow(order);
+        } else if(order->side == Side::Buy) {
+            buyQueue_.push(OrderHandle(order));
+            if(batching_) buyQueued_ = true;
+            else buyWait_.notify();
+        } else {
+            sellQueue_.push(OrderHandle(order));
+            if(batching_) sellQueued_ = true;
+            else sellWait_.notify();
         }
-        if(orderType == OrderType::IOC) {
-            // Process IOC orders immediately.
-            processOrder(order);
-            if(order->quantity > 0) {
-                cout << "[OrderBook] IOC order partially filled -> ID=" << orderId
-                     << ", side=" << side << ", remaining quantity: " << order->quantity << "\n";
-                order->quantity = 0;
-            }
-            return;
+    }
+
+    // Defers processor wake-ups for the lifetime of a batch. Caller holds mtx_.
+    struct BatchScope {
+        BasicOrderBook &book;
+        explicit BatchScope(BasicOrderBook &b) : book(b) { book.batching_ = true; }
+        ~BatchScope() {
+            book.batching_ = false;
+            if(book.buyQueued_) book.buyWait_.notify();
+            if(book.sellQueued_) book.sellWait_.notify();
+            book.buyQueued_ = book.sellQueued_ = false;
         }
-        {
-            lock_guard<mutex> lock(mtx_);
-            // Use TBB's accessor API instead of operator[].
-            ActiveOrdersMap::accessor acc;
-            activeOrders_.insert(acc, orderId);
-            acc->second = order;
-            
-            if(side == "buy") {
-                buyOrders_[price].push_back(order);
-                buyQueue_.push(order);
-            } else {
-                sellOrders_[price].push_back(order);
-                sellQueue_.push(order);
-            }
+    };
+
+    // The single-item operations behind both the single and batch entry
+    // points. Caller holds mtx_.
+    bool placeStop(int orderId, double stopPrice, int quantity, Side side) {
+        bool isBuy = side == Side::Buy;
+        Price ticks = scale_.toTicks(stopPrice);
+        if(activeOrders_.contains(orderId) || !stops_.add(orderId, ticks, quantity, isBuy)) {
+            reject(orderId, isBuy, OrderType::Stop, RejectReason::DuplicateId);
+            return false;
         }
-        cout << "[OrderBook] addOrder -> ID=" << orderId << ", side=" << side << "\n";
+        emit(stopEvent(EventType::Accept, StopOrder{orderId, ticks, quantity, isBuy}));
+        finishMutation();
+        return true;
     }
-    
-    // Display the current order book.
-    inline void displayOrders() {
-        lock_guard<mutex> lock(mtx_);
-        cout << "[OrderBook] displayOrders\n";
-        cout << "Buy Orders:\n";
-        for(auto &kv : buyOrders_) {
-            cout << "  Price " << kv.first << ": ";
-            for(auto &ord : kv.second)
-                cout << "(ID=" << ord->orderId << ", qty=" << ord->quantity << ") ";
-            cout << "\n";
+
+    bool place(int orderId, double price, int quantity, Side side, OrderType orderType) {
+        // A stop order's price is its trigger.
+        if(orderType == OrderType::Stop)
+            return placeStop(orderId, price, quantity, side);
+        if(orderType == OrderType::Market || orderType == OrderType::IOC) {
+            // Process market and IOC orders immediately; they never rest, so no pool slot is needed.
+            Order order{orderType, orderId, scale_.toTicks(price), quantity, side};
+            executeImmediate(&order);
+            finishMutation();
+            return true;
         }
-        cout << "Sell Orders:\n";
-        for(auto &kv : sellOrders_) {
-            cout << "  Price " << kv.first << ": ";
-            for(auto &ord : kv.second)
-                cout << "(ID=" << ord->orderId << ", qty=" << ord->quantity << ") ";
-            cout << "\n";
+        Price ticks = scale_.toTicks(price);
+        bool isBuy = side == Side::Buy;
+        if(!(isBuy ? buyOrders_.representable(ticks) : sellOrders_.representable(ticks))) {
+            reject(orderId, isBuy, orderType, RejectReason::PriceOutOfRange);
+            return false;
+        }
+        if(stops_.contains(orderId) || activeOrders_.contains(orderId)) {
+            reject(orderId, isBuy, orderType, RejectReason::DuplicateId);
+            return false;
+        }
+        Order *order = pool_.acquire();
+        if(order == nullptr) {
+            reject(orderId, isBuy, orderType, RejectReason::PoolExhausted);
+            return false;
         }
+        order->orderType = orderType;
+        order->orderId = orderId;
+        order->price = ticks;
+        order->quantity = quantity;
+        order->side = side;
+        order->timestamp = ++arrivals_;
+        activeOrders_.insert(orderId, order);
+
+        PriceLevel *lvl = isBuy ? buyOrders_.insertLevel(ticks) : sellOrders_.insertLevel(ticks);
+        markLevel(isBuy, *lvl);
+        lvl->push_back(order);
+        emit(orderEvent(EventType::Accept, *order, quantity));
+        announceResting(OrderFeedType::Add, *order);
+        enqueueForMatching(order);
+        flushPending();
+        finishMutation();
+        return true;
     }
-    
-    // Return the current best bid.
-    inline double getBestBid() {
-        lock_guard<mutex> lock(mtx_);
-        if(!buyOrders_.empty())
-            return buyOrders_.begin()->first;
-        return 0.0;
-    }
-    
-    // Return the current best ask.
-    inline double getBestAsk() {
-        lock_guard<mutex> lock(mtx_);
-        if(!sellOrders_.empty())
-            return sellOrders_.begin()->first;
-        return 0.0;
-    }
-    
-    // Cancel an order by its ID.
-    inline bool cancelOrder(int orderId) {
-        lock_guard<mutex> lock(mtx_);
-        ActiveOrdersMap::accessor acc;
-        if(!activeOrders_.find(acc, orderId))
-            return false; // not found
-    
-        OrderPointer order = acc->second;
-        double price = order->price;
-        if(order->side == "buy") {
-            auto mapIt = buyOrders_.find(price);
-            if(mapIt != buyOrders_.end()) {
-                auto &lst = mapIt->second;
-                lst.remove_if([orderId](const OrderPointer &o){ return o->orderId == orderId; });
-                if(lst.empty())
-                    buyOrders_.erase(mapIt);
-            }
-        } else {
-            auto mapIt = sellOrders_.find(price);
-            if(mapIt != sellOrders_.end()) {
-                auto &lst = mapIt->second;
-                lst.remove_if([orderId](const OrderPointer &o){ return o->orderId == orderId; });
-                if(lst.empty())
-                    sellOrders_.erase(mapIt);
-            }
+
+    bool cancel(int orderId) {
+        Order *order = activeOrders_.find(orderId);
+        if(order == nullptr) {
+            StopOrder stop;
+            if(!stops_.cancel(orderId, stop))
+                return false; // not found
+            emit(stopEvent(EventType::CancelAck, stop));
+            return true;
         }
-        activeOrders_.erase(acc);
-        cout << "[OrderBook] cancelOrder -> ID=" << orderId << "\n";
+
+        markLevel(order->side == Side::Buy, *order->level);
+        if(order->side == Side::Buy)
+            removeFromLevel(buyOrders_, order);
+        else
+            removeFromLevel(sellOrders_, order);
+        activeOrders_.erase(orderId);
+        emit(orderEvent(EventType::CancelAck, *order, order->quantity));
+        if(feed_ != nullptr)
+            announce(OrderFeedType::Delete, orderId, order->side, order->price, order->quantity);
+        pool_.release(order);
+        finishMutation();
         return true;
     }
-    
-    // Modify an order's quantity and price.
-    inline bool modifyOrder(int orderId, int newQuantity, double newPrice) {
-        lock_guard<mutex> lock(mtx_);
-        ActiveOrdersMap::accessor acc;
-        if(!activeOrders_.find(acc, orderId))
+
+    bool modify(int orderId, int newQuantity, double newPrice) {
+        Order *order = activeOrders_.find(orderId);
+        if(order == nullptr)
             return false;
-        OrderPointer order = acc->second;
-        double oldPrice = order->price;
-        if(order->side == "buy") {
-            auto mapIt = buyOrders_.find(oldPrice);
-            if(mapIt != buyOrders_.end()) {
-                auto &lst = mapIt->second;
-                lst.remove_if([orderId](const OrderPointer &o){ return o->orderId == orderId; });
-                if(lst.empty())
-                    buyOrders_.erase(mapIt);
+        bool isBuy = order->side == Side::Buy;
+        Price newTicks = scale_.toTicks(newPrice);
+        if(!(isBuy ? buyOrders_.representable(newTicks) : sellOrders_.representable(newTicks))) {
+            reject(orderId, isBuy, order->orderType, RejectReason::PriceOutOfRange);
+            return false;
+        }
+        markLevel(isBuy, *order->level);
+        if(isBuy)
+            removeFromLevel(buyOrders_, order);
+        else
+            removeFromLevel(sellOrders_, order);
+
+        order->price = newTicks;
+        order->quantity = newQuantity;
+        order->timestamp = ++arrivals_;   // a modified order loses its queue priority
+        PriceLevel *lvl = isBuy ? buyOrders_.insertLevel(newTicks) : sellOrders_.insertLevel(newTicks);
+        markLevel(isBuy, *lvl);
+        lvl->push_back(order);
+        emit(orderEvent(EventType::ModifyAck, *order, newQuantity));
+        announceResting(OrderFeedType::Replace, *order);
+        enqueueForMatching(order);
+        flushPending();
+        finishMutation();
+        return true;
+    }
+
+
+public:
+    explicit BasicOrderBook(const PriceScale &scale = {}, const typename Levels::Config &config = {},
+                            const OrderPool::Config &poolConfig = {}, WaitMode waitMode = WaitMode::Blocking,
+                            const OrderIndex::Config &indexConfig = {})
+        : buyOrders_(config, scale), sellOrders_(config, scale), scale_(scale), pool_(poolConfig),
+          activeOrders_(indexConfig), buyWait_(waitMode), sellWait_(waitMode) {}
+
+    const PriceScale& priceScale() const { return scale_; }
+
+    // Routes execution events into `ring` (nullptr to turn them off). Call
+    // before the book is in use.
+    void setEventRing(EventRing *ring) { events_ = ring; }
+
+    // Routes L2 depth updates into `ring` (nullptr to turn them off). Call
+    // before the book is in use.
+    void setDepthRing(DepthRing *ring) { depth_ = ring; }
+
+    // Keeps `publisher`'s depth view current (nullptr to turn it off). Call
+    // before the book is in use.
+    void setConflatingPublisher(ConflatingPublisher *publisher) { conflated_ = publisher; }
+
+    // Routes L3 order messages into `ring` (nullptr to turn them off). Call
+    // before the book is in use.
+    void setOrderFeed(OrderFeedRing *ring) { feed_ = ring; }
+
+    // The bound listener, for configuring it before the book is in use.
+    Listener& listener() { return listener_; }
+
+    // Clears the order book.
+    inline void reset() {
+        lock_guard<Mutex> lock(mtx_);
+        clearState();
+        BookEvent event;
+        event.type = EventType::Reset;
+        emit(event);
+        publishTopOfBook();
+    }
+
+    // Copies the full book state into `out` (see Snapshot.hpp); the caller
+    // sets the sequence. Costs one pass over the resting orders and stops.
+    inline void captureSnapshot(BookSnapshot &out) {
+        lock_guard<Mutex> lock(mtx_);
+        out.header = SnapshotHeader{};
+        out.header.arrivals = arrivals_;
+        out.header.lastTradePrice = lastTradePrice_;
+        out.header.traded = traded_;
+        out.header.tickSize = scale_.tickSize;
+        out.entries.clear();
+        out.entries.reserve(pool_.inUse() + stops_.size());
+        auto addLevel = [&out](Price, const PriceLevel &lvl) {
+            for(const Order *o = lvl.front(); o != nullptr; o = o->next) {
+                SnapshotEntry e;
+                e.price = o->price;
+                e.timestamp = o->timestamp;
+                e.orderId = o->orderId;
+                e.quantity = o->quantity;
+                e.side = o->side;
+                e.orderType = o->orderType;
+                out.entries.push_back(e);
             }
-        } else {
-            auto mapIt = sellOrders_.find(oldPrice);
-            if(mapIt != sellOrders_.end()) {
-                auto &lst = mapIt->second;
-                lst.remove_if([orderId](const OrderPointer &o){ return o->orderId == orderId; });
-                if(lst.empty())
-                    sellOrders_.erase(mapIt);
+        };
+        buyOrders_.forEachLevel(addLevel);
+        sellOrders_.forEachLevel(addLevel);
+        out.header.orderCount = out.entries.size();
+        stops_.forEach([&out](const StopOrder &stop) {
+            SnapshotEntry e;
+            e.price = stop.stopPrice;
+            e.orderId = stop.orderId;
+            e.quantity = stop.quantity;
+            e.side = stop.buy ? Side::Buy : Side::Sell;
+            e.orderType = OrderType::Stop;
+            out.entries.push_back(e);
+        });
+        out.header.stopCount = out.entries.size() - out.header.orderCount;
+    }
+
+    // Copies the best `levels` price levels of each side into `out`, stamped
+    // with the last depth update they reflect, so a DepthBook loaded from it
+    // can continue from the ring. Costs O(levels); on a single-writer book,
+    // call it from the writer thread.
+    inline void captureDepth(size_t levels, DepthSnapshot &out) {
+        lock_guard<Mutex> lock(mtx_);
+        out.sequence = depthSequence_;
+        out.bids.clear();
+        out.asks.clear();
+        auto copyTo = [](vector<DepthLevel> &side) {
+            return [&side](Price price, const PriceLevel &lvl) {
+                side.push_back(DepthLevel{price, lvl.quantity, static_cast<uint32_t>(lvl.count)});
+            };
+        };
+        buyOrders_.forBestLevels(levels, copyTo(out.bids));
+        sellOrders_.forBestLevels(levels, copyTo(out.asks));
+    }
+
+    // Replaces the book's contents with a captured state, re-linking orders in
+    // their saved queue positions without matching or electing stops.
+    // `entries` holds header.orderCount orders followed by header.stopCount
+    // stops. Returns false (leaving the book empty) if the tick size differs,
+    // a price does not fit this book's levels, or the pool runs out.
+    inline bool restoreSnapshot(const SnapshotHeader &header, const SnapshotEntry *entries) {
+        lock_guard<Mutex> lock(mtx_);
+        clearState();
+        bool ok = header.tickSize == scale_.tickSize;
+        for(uint64_t i = 0; ok && i < header.orderCount; ++i) {
+            const SnapshotEntry &e = entries[i];
+            bool isBuy = e.side == Side::Buy;
+            Order *order = nullptr;
+            ok = (isBuy ? buyOrders_.representable(e.price) : sellOrders_.representable(e.price)) &&
+                 (order = pool_.acquire()) != nullptr;
+            if(!ok)
+                break;
+            order->orderType = e.orderType;
+            order->orderId = e.orderId;
+            order->price = e.price;
+            order->quantity = e.quantity;
+            order->side = e.side;
+            order->timestamp = e.timestamp;
+            ok = activeOrders_.insert(e.orderId, order);
+            if(!ok) {
+                pool_.release(order);
+                break;
             }
+            PriceLevel *lvl = isBuy ? buyOrders_.insertLevel(e.price) : sellOrders_.insertLevel(e.price);
+            markLevel(isBuy, *lvl);
+            lvl->push_back(order);
+            if(feed_ != nullptr)
+                announce(OrderFeedType::Add, e.orderId, e.side, e.price, e.quantity);
         }
-    
-        order->price = newPrice;
-        order->quantity = newQuantity;
-        if(order->side == "buy") {
-            buyOrders_[newPrice].push_back(order);
-            buyQueue_.push(order);
+        for(uint64_t i = 0; ok && i < header.stopCount; ++i) {
+            const SnapshotEntry &e = entries[header.orderCount + i];
+            ok = stops_.add(e.orderId, e.price, e.quantity, e.side == Side::Buy);
+        }
+        if(ok) {
+            arrivals_ = header.arrivals;
+            lastTradePrice_ = header.lastTradePrice;
+            traded_ = header.traded != 0;
         } else {
-            sellOrders_[newPrice].push_back(order);
-            sellQueue_.push(order);
+            clearState();
         }
-        cout << "[OrderBook] modifyOrder -> ID=" << orderId << "\n";
-        return true;
+        publishDepth();
+        publishTopOfBook();
+        return ok;
+    }
+
+    // Rests a stop order that executes as a market order once the last trade
+    // or the touch reaches `stopPrice` (at or above it for buys, at or below
+    // it for sells); a stop already crossed executes right away. Returns false
+    // if the order was rejected.
+    inline bool addStopOrder(int orderId, double stopPrice, int quantity, Side side) {
+        lock_guard<Mutex> lock(mtx_);
+        return placeStop(orderId, stopPrice, quantity, side);
+    }
+
+    // String-side overloads kept for existing callers.
+    inline bool addStopOrder(int orderId, double stopPrice, int quantity, const string& side) {
+        return addStopOrder(orderId, stopPrice, quantity, toSide(side));
+    }
+
+    inline bool addOrder(int orderId, double price, int quantity,
+                         const string& side, OrderType orderType) {
+        return addOrder(orderId, price, quantity, toSide(side), orderType);
+    }
+
+    // Add an order to the book. Returns false if the order was rejected.
+    inline bool addOrder(int orderId, double price, int quantity,
+                         Side side, OrderType orderType)
+    {
+        lock_guard<Mutex> lock(mtx_);
+        return place(orderId, price, quantity, side, orderType);
+    }
+
+    // Batch entry points: the book is locked once for the whole batch and
+    // the items are applied in array order, exactly as the same sequence of
+    // single calls would apply them (stops elected after each item).
+    // `accepted[i]` receives item i's result; returns the number accepted.
+    inline size_t addOrders(const OrderRequest *orders, size_t count, bool *accepted) {
+        lock_guard<Mutex> lock(mtx_);
+        BatchScope batch(*this);
+        size_t n = 0;
+        for(size_t i = 0; i < count; ++i) {
+            const OrderRequest &o = orders[i];
+            accepted[i] = place(o.orderId, o.price, o.quantity, o.side, o.orderType);
+            n += accepted[i];
+        }
+        return n;
+    }
+
+    inline size_t cancelOrders(const int *orderIds, size_t count, bool *cancelled) {
+        lock_guard<Mutex> lock(mtx_);
+        size_t n = 0;
+        for(size_t i = 0; i < count; ++i) {
+            cancelled[i] = cancel(orderIds[i]);
+            n += cancelled[i];
+        }
+        return n;
+    }
+
+    inline size_t modifyOrders(const ModifyRequest *modifies, size_t count, bool *modified) {
+        lock_guard<Mutex> lock(mtx_);
+        BatchScope batch(*this);
+        size_t n = 0;
+        for(size_t i = 0; i < count; ++i) {
+            const ModifyRequest &m = modifies[i];
+            modified[i] = modify(m.orderId, m.newQuantity, m.newPrice);
+            n += modified[i];
+        }
+        return n;
+    }
+
+    // Display the current order book.
+    inline void displayOrders() {
+        lock_guard<Mutex> lock(mtx_);
+        auto printLevel = [this](Price price, const PriceLevel &lvl) {
+            cout << "  Price " << scale_.toDouble(price) << ": ";
+            for(const Order *ord = lvl.front(); ord != nullptr; ord = ord->next)
+                cout << "(ID=" << ord->orderId << ", qty=" << ord->quantity << ") ";
+            cout << "\n";
+        };
+        cout << "[OrderBook] displayOrders\n";
+        cout << "Buy Orders:\n";
+        buyOrders_.forEachLevel(printLevel);
+        cout << "Sell Orders:\n";
+        sellOrders_.forEachLevel(printLevel);
+    }
+
+    // Best bid/ask with their sizes as of the last completed mutation. Reads
+    // a seqlock, never mtx_, so any number of threads can poll it while
+    // matching runs.
+    inline TopOfBookSnapshot topOfBook() const { return quote_.read(); }
+
+    // Return the current best bid (0.0 if there are no bids), without locking.
+    inline double getBestBid() const {
+        TopOfBook top = quote_.read().top;
+        return top.hasBid ? scale_.toDouble(top.bidPrice) : 0.0;
+    }
+
+    // Return the current best ask (0.0 if there are no asks), without locking.
+    inline double getBestAsk() const {
+        TopOfBook top = quote_.read().top;
+        return top.hasAsk ? scale_.toDouble(top.askPrice) : 0.0;
+    }
+
+    // Cancel an order (resting or stop) by its ID.
+    inline bool cancelOrder(int orderId) {
+        lock_guard<Mutex> lock(mtx_);
+        return cancel(orderId);
+    }
+
+    // Modify an order's quantity and price.
+    inline bool modifyOrder(int orderId, int newQuantity, double newPrice) {
+        lock_guard<Mutex> lock(mtx_);
+        return modify(orderId, newQuantity, newPrice);
     }
-    
+
     // Asynchronous processing thread for buy orders.
     inline void processBuyOrders() {
-        OrderPointer order;
+        OrderHandle order;
+        unsigned spins = 0;
+        auto ready = [this]{ return !buyQueue_.empty() || !running_; };
         while(running_)
         {
-            //try_pop is non-blocking, sleep if the queue is empty
-            if(buyQueue_.try_pop(order)) matchBuyOrder(order);
-            else this_thread::sleep_for(chrono::milliseconds(1));
+            //try_pop is non-blocking, idle per the wait strategy if the queue is empty
+            if(buyQueue_.try_pop(order)) { matchBuyOrder(order); spins = 0; }
+            else buyWait_.idle(spins, ready);
         }
     }
-    
+
     // Asynchronous processing thread for sell orders.
     inline void processSellOrders() {
-        OrderPointer order;
+        OrderHandle order;
+        unsigned spins = 0;
+        auto ready = [this]{ return !sellQueue_.empty() || !running_; };
         while (running_) {
-            if (sellQueue_.try_pop(order))
+            if (sellQueue_.try_pop(order)) {
                 matchSellOrder(order);
-            else
-                this_thread::sleep_for(chrono::milliseconds(1));
+                spins = 0;
+            } else {
+                sellWait_.idle(spins, ready);
+            }
         }
     }
-    
+
     // Synchronous processing method (for immediate processing).
     inline void processOrder(OrderPointer order) {
-        if(order->side == "buy")
-            matchBuyOrder(order);
-        else if(order->side == "sell")
-            matchSellOrder(order);
+        lock_guard<Mutex> lock(mtx_);
+        executeImmediate(order.get());
+        finishMutation();
+    }
+
+    // Number of stop orders waiting for their trigger.
+    inline size_t pendingStopOrders() {
+        lock_guard<Mutex> lock(mtx_);
+        return stops_.size();
     }
-    
+
     // Stop the processing threads.
     inline void stopProcessing() {
         running_ = false;
+        buyWait_.notify();
+        sellWait_.notify();
     }
-};
\ No newline at end of file
+};
+
+// Map-based book (the default) and the array price ladder variant.
+using OrderBook = BasicOrderBook<MapPriceLevels>;
+using LadderOrderBook = BasicOrderBook<PriceLadder>;
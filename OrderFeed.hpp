@@ -0,0 +1,55 @@
+#pragma once
+#include "Order.hpp"
+#include "Ring.hpp"
+#include <atomic>
+#include <cstdint>
+using namespace std;
+
+// Market-by-order (L3) feed in the style of ITCH: every order that becomes
+// visible on the book is announced, and every later change to it is
+// reported against its ID, so a consumer can rebuild each price level's
+// queue. Orders that never rest (market, IOC, elected stops, limits that
+// fill on arrival) appear only as executions against the resting side.
+// Messages are fixed 32-byte records pushed into a preallocated ring; the
+// record is the wire format, so a consumer can forward or log it as bytes.
+
+enum class OrderFeedType : uint8_t {
+    Add = 'A',      // order rests: price, side, open quantity
+    Execute = 'E',  // resting order traded `quantity` at `price` with contraOrderId; leaves the book at 0
+    Delete = 'D',   // order cancelled (or emptied by a replace that filled)
+    Replace = 'U',  // order re-priced / re-sized (same ID, back of the queue at `price`)
+    Clear = 'C'     // book reset or restored; drop every order
+};
+
+struct OrderMessage {
+    uint64_t sequence = 0;      // per-book feed sequence, no gaps
+    Price price = 0;
+    int32_t orderId = 0;
+    int32_t contraOrderId = 0;  // Execute only: the other side of the trade
+    int32_t quantity = 0;       // Add/Replace: open quantity, Execute: traded, Delete: removed (0 after a replace filled)
+    OrderFeedType type = OrderFeedType::Add;
+    Side side = Side::Buy;
+    uint8_t reserved[2] = {};
+};
+
+static_assert(sizeof(OrderMessage) == 32, "order feed message layout");
+
+// Written under the book's lock; never blocks it. Messages that do not fit
+// are dropped and counted, which the consumer sees as a sequence gap.
+class OrderFeedRing {
+public:
+    explicit OrderFeedRing(size_t capacity = 1 << 16) : ring_(capacity) {}
+
+    void publish(const OrderMessage &message) {
+        if(!ring_.push(message))
+            dropped_.fetch_add(1, memory_order_relaxed);
+    }
+
+    bool poll(OrderMessage &message) { return ring_.pop(message); }
+    bool empty() const { return ring_.empty(); }
+    uint64_t dropped() const { return dropped_.load(memory_order_relaxed); }
+
+private:
+    SpscRing<OrderMessage> ring_;
+    atomic<uint64_t> dropped_{0};
+};
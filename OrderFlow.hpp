@@ -0,0 +1,197 @@
+#pragma once
+#include "Command.hpp"
+#include "Snapshot.hpp"
+#include "LatencyHistogram.hpp"
+#include "Ring.hpp"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+// Recorded order flow for replay: a 16-byte header followed by fixed 32-byte
+// timestamped events (add of any order type, cancel, modify). The replayer
+// walks a memory-mapped file in place, so a run measures the book rather
+// than a parser. POSIX only.
+
+struct OrderFlowHeader {
+    char magic[8] = {'O', 'B', 'F', 'L', 'O', 'W', '0', '1'};
+    uint32_t version = 1;
+    uint32_t eventSize = 32;
+};
+
+struct FlowEvent {
+    uint64_t timestamp = 0;     // ns since the start of the recording, non-decreasing
+    int32_t orderId = 0;
+    int32_t quantity = 0;       // Add: order size, Modify: new size
+    double price = 0.0;         // Add: limit price (trigger for a stop), Modify: new price
+    CommandType type = CommandType::Add;
+    OrderType orderType = OrderType::Limit;   // Add only: Limit, Market, IOC or Stop
+    Side side = Side::Buy;
+    uint8_t reserved[5] = {};
+
+    Command command() const {
+        Command c;
+        c.type = type;
+        c.orderType = orderType;
+        c.buy = side == Side::Buy;
+        c.orderId = orderId;
+        c.quantity = quantity;
+        c.price = price;
+        return c;
+    }
+};
+
+static_assert(sizeof(OrderFlowHeader) == 16, "order flow header layout");
+static_assert(sizeof(FlowEvent) == 32, "order flow event layout");
+
+// Writes `events` to `path` as an order flow file. Returns false on an I/O error.
+inline bool writeOrderFlow(const string &path, const vector<FlowEvent> &events) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+    OrderFlowHeader header;
+    const char *parts[2] = {reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(events.data())};
+    size_t sizes[2] = {sizeof(header), events.size() * sizeof(FlowEvent)};
+    bool ok = true;
+    for(int i = 0; i < 2 && ok; ++i) {
+        while(sizes[i] > 0) {
+            ssize_t n = ::write(fd, parts[i], sizes[i]);
+            if(n <= 0) {
+                ok = false;
+                break;
+            }
+            parts[i] += n;
+            sizes[i] -= static_cast<size_t>(n);
+        }
+    }
+    return ::close(fd) == 0 && ok;
+}
+
+// Read-only mapping of an order flow file. A trailing partial event is ignored.
+class MappedOrderFlow {
+public:
+    MappedOrderFlow() = default;
+    ~MappedOrderFlow() { close(); }
+
+    MappedOrderFlow(const MappedOrderFlow&) = delete;
+    MappedOrderFlow& operator=(const MappedOrderFlow&) = delete;
+
+    // Returns false if the file is missing or not an order flow file.
+    bool open(const string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(OrderFlowHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(map == MAP_FAILED)
+            return false;
+        map_ = map;
+        OrderFlowHeader expected;
+        if(memcmp(map_, &expected, sizeof(expected)) != 0) {
+            close();
+            return false;
+        }
+        madvise(map_, size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if(map_ != nullptr)
+            munmap(map_, size_);
+        map_ = nullptr;
+        size_ = 0;
+    }
+
+    const FlowEvent* events() const {
+        return reinterpret_cast<const FlowEvent*>(static_cast<const char*>(map_) + sizeof(OrderFlowHeader));
+    }
+    size_t size() const { return size_ < sizeof(OrderFlowHeader) ? 0 : (size_ - sizeof(OrderFlowHeader)) / sizeof(FlowEvent); }
+
+private:
+    void *map_ = nullptr;
+    size_t size_ = 0;
+};
+
+// FNV-1a over the book's full captured state (resting orders in queue order,
+// pending stops, last trade price). Two books that processed the same flow
+// have the same checksum.
+template<typename Book>
+uint64_t bookChecksum(Book &book) {
+    BookSnapshot snapshot;
+    book.captureSnapshot(snapshot);
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void *data, size_t size) {
+        const unsigned char *p = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < size; ++i)
+            hash = (hash ^ p[i]) * 1099511628211ull;
+    };
+    mix(&snapshot.header.orderCount, sizeof(snapshot.header.orderCount));
+    mix(&snapshot.header.stopCount, sizeof(snapshot.header.stopCount));
+    mix(&snapshot.header.lastTradePrice, sizeof(snapshot.header.lastTradePrice));
+    mix(snapshot.entries.data(), snapshot.entries.size() * sizeof(SnapshotEntry));
+    return hash;
+}
+
+struct ReplayOptions {
+    bool paced = false;     // false: as fast as possible; true: at the recorded timestamps
+    double speed = 1.0;     // pace multiplier when paced (2.0 = twice as fast as recorded)
+    bool timeEvents = true; // record per-event latency (two clock reads per event)
+};
+
+struct ReplayReport {
+    uint64_t events = 0;
+    uint64_t accepted = 0;
+    double seconds = 0.0;
+    double eventsPerSecond = 0.0;
+    uint64_t checksum = 0;          // bookChecksum() after the last event
+    LatencyHistogram latency;       // ns per event, inside the book
+};
+
+// Feeds `count` events through `book` on the calling thread and fills `report`.
+// When paced, each event waits (spinning) for its recorded offset from the
+// first event, scaled by `speed`; the wait is not counted as latency.
+template<typename Book>
+void replayOrderFlow(Book &book, const FlowEvent *events, size_t count,
+                     const ReplayOptions &options, ReplayReport &report) {
+    using Clock = chrono::steady_clock;
+    report.latency.reset();
+    report.events = count;
+    report.accepted = 0;
+    uint64_t origin = count ? events[0].timestamp : 0;
+    double scale = options.speed > 0.0 ? 1.0 / options.speed : 1.0;
+    auto start = Clock::now();
+    for(size_t i = 0; i < count; ++i) {
+        const FlowEvent &event = events[i];
+        if(options.paced) {
+            uint64_t offset = event.timestamp > origin ? event.timestamp - origin : 0;
+            auto due = start + chrono::nanoseconds(static_cast<int64_t>(offset * scale));
+            while(Clock::now() < due)
+                cpuRelax();
+        }
+        Command command = event.command();
+        if(options.timeEvents) {
+            auto t0 = Clock::now();
+            report.accepted += applyCommand(book, command);
+            auto t1 = Clock::now();
+            report.latency.record(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+        } else {
+            report.accepted += applyCommand(book, command);
+        }
+    }
+    report.seconds = chrono::duration<double>(Clock::now() - start).count();
+    report.eventsPerSecond = report.seconds > 0.0 ? count / report.seconds : 0.0;
+    report.checksum = bookChecksum(book);
+}
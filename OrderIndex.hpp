@@ -0,0 +1,174 @@
+#pragma once
+#include "Order.hpp"
+#include "OrderPool.hpp"
+#include "Ring.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+using namespace std;
+
+struct OrderIndexConfig {
+    size_t denseLimit = size_t(1) << 22;   // IDs in [0, denseLimit) are indexed directly
+    size_t initialDense = size_t(1) << 14; // dense slots allocated up front; grows by doubling
+    size_t initialSparse = 64;             // sparse table slots (power of two)
+};
+
+// Maps order IDs to their pool slots. Dense, exchange-assigned IDs index a
+// flat slab directly; anything else (negative or very large client IDs) goes
+// to an open-addressing table with linear probing. Each entry is an
+// OrderHandle, so an ID whose slot was recycled without being erased reads as
+// absent. Not thread-safe: the owning book calls it under its own lock.
+class OrderIndex {
+public:
+    using Config = OrderIndexConfig;
+
+    explicit OrderIndex(const Config &config = {})
+        : config_(config), dense_(min(config.initialDense, config.denseLimit)),
+          sparse_(roundUpToPowerOfTwo(config.initialSparse < 2 ? 2 : config.initialSparse)) {}
+
+    // Returns false if `orderId` already maps to a live order.
+    bool insert(int orderId, Order *order) {
+        OrderHandle *entry = isDense(orderId) ? denseSlot(orderId) : sparseSlot(orderId);
+        if(entry->valid())
+            return false;
+        if(entry->order == nullptr)
+            ++size_;
+        *entry = OrderHandle(order);
+        return true;
+    }
+
+    // The live order for `orderId`, or nullptr.
+    Order* find(int orderId) const {
+        const OrderHandle *entry = nullptr;
+        if(isDense(orderId)) {
+            if(static_cast<size_t>(orderId) < dense_.size())
+                entry = &dense_[orderId];
+        } else {
+            size_t i = probe(orderId);
+            if(sparse_[i].used)
+                entry = &sparse_[i].handle;
+        }
+        return entry != nullptr && entry->valid() ? entry->order : nullptr;
+    }
+
+    bool contains(int orderId) const { return find(orderId) != nullptr; }
+
+    // Returns false if `orderId` had no entry.
+    bool erase(int orderId) {
+        if(isDense(orderId)) {
+            if(static_cast<size_t>(orderId) >= dense_.size() || dense_[orderId].order == nullptr)
+                return false;
+            dense_[orderId] = OrderHandle();
+        } else {
+            size_t i = probe(orderId);
+            if(!sparse_[i].used)
+                return false;
+            eraseSparse(i);
+        }
+        --size_;
+        return true;
+    }
+
+    // Calls f(Order*) for every live entry.
+    template<typename F>
+    void forEach(F &&f) const {
+        for(const OrderHandle &entry : dense_)
+            if(entry.valid())
+                f(entry.order);
+        for(const SparseSlot &slot : sparse_)
+            if(slot.used && slot.handle.valid())
+                f(slot.handle.order);
+    }
+
+    // Entries inserted and not yet erased (including any gone stale).
+    size_t size() const { return size_; }
+
+    void clear() {
+        fill(dense_.begin(), dense_.end(), OrderHandle());
+        fill(sparse_.begin(), sparse_.end(), SparseSlot());
+        sparseUsed_ = 0;
+        size_ = 0;
+    }
+
+private:
+    struct SparseSlot {
+        int key = 0;
+        bool used = false;
+        OrderHandle handle;
+    };
+
+    Config config_;
+    vector<OrderHandle> dense_;
+    vector<SparseSlot> sparse_;
+    size_t sparseUsed_ = 0;
+    size_t size_ = 0;
+
+    bool isDense(int orderId) const {
+        return orderId >= 0 && static_cast<size_t>(orderId) < config_.denseLimit;
+    }
+
+    OrderHandle* denseSlot(int orderId) {
+        size_t id = static_cast<size_t>(orderId);
+        if(id >= dense_.size())
+            dense_.resize(min(max(id + 1, dense_.size() * 2), config_.denseLimit));
+        return &dense_[id];
+    }
+
+    size_t home(int key) const {
+        // Fibonacci hashing spreads sequential client IDs across the table.
+        return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(key)) * 0x9E3779B97F4A7C15ull) >> 32)
+               & (sparse_.size() - 1);
+    }
+
+    // Slot holding `key`, or the empty slot where it would go.
+    size_t probe(int key) const {
+        size_t mask = sparse_.size() - 1;
+        size_t i = home(key);
+        while(sparse_[i].used && sparse_[i].key != key)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    OrderHandle* sparseSlot(int key) {
+        size_t i = probe(key);
+        if(!sparse_[i].used) {
+            // keep the load factor at or below one half
+            if((sparseUsed_ + 1) * 2 > sparse_.size()) {
+                rehash(sparse_.size() * 2);
+                i = probe(key);
+            }
+            sparse_[i].used = true;
+            sparse_[i].key = key;
+            ++sparseUsed_;
+        }
+        return &sparse_[i].handle;
+    }
+
+    void rehash(size_t capacity) {
+        vector<SparseSlot> old(capacity);
+        old.swap(sparse_);
+        for(const SparseSlot &slot : old)
+            if(slot.used)
+                sparse_[probe(slot.key)] = slot;
+    }
+
+    // Backward-shift deletion: pulls later members of the probe run into the
+    // hole so lookups never need tombstones.
+    void eraseSparse(size_t hole) {
+        size_t mask = sparse_.size() - 1;
+        size_t i = (hole + 1) & mask;
+        while(sparse_[i].used) {
+            size_t h = home(sparse_[i].key);
+            // move slot i back if its home is not cyclically within (hole, i]
+            bool movable = hole <= i ? (h <= hole || h > i) : (h <= hole && h > i);
+            if(movable) {
+                sparse_[hole] = sparse_[i];
+                hole = i;
+            }
+            i = (i + 1) & mask;
+        }
+        sparse_[hole] = SparseSlot();
+        --sparseUsed_;
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "Order.hpp"
+#include <vector>
+#include <memory>
+#include <cstddef>
+using namespace std;
+
+// Reference to a pooled order that detects recycling of its slot.
+struct OrderHandle {
+    Order *order = nullptr;
+    uint32_t generation = 0;
+
+    OrderHandle() = default;
+    explicit OrderHandle(Order *o) : order(o), generation(o->generation) {}
+
+    bool valid() const { return order != nullptr && order->generation == generation; }
+};
+
+// Preallocated pool of Order records handed out from an intrusive free list
+// (linked through Order::next). Slots are never returned to the heap while the
+// pool lives, so a stale Order* stays readable; Order::generation is bumped on
+// every release so holders of an old pointer can tell the slot was recycled.
+// Not thread-safe: the owning book calls it under its own lock.
+struct OrderPoolConfig {
+    size_t capacity = 1 << 14;  // slots allocated up front
+    bool growable = true;       // add another block of `capacity` slots when exhausted
+};
+
+class OrderPool {
+public:
+    using Config = OrderPoolConfig;
+
+    explicit OrderPool(const Config &config = {}) : config_(config) {
+        grow();
+    }
+
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    // Returns a cleared slot (generation preserved), or nullptr if the pool is
+    // exhausted and not growable.
+    Order* acquire() {
+        if(freeList_ == nullptr) {
+            if(!config_.growable)
+                return nullptr;
+            grow();
+        }
+        Order *order = freeList_;
+        freeList_ = order->next;
+        uint32_t generation = order->generation;
+        *order = Order{};
+        order->generation = generation;
+        ++inUse_;
+        return order;
+    }
+
+    void release(Order *order) {
+        ++order->generation;
+        order->level = nullptr;
+        order->prev = nullptr;
+        order->next = freeList_;
+        freeList_ = order;
+        --inUse_;
+    }
+
+    size_t capacity() const { return blocks_.size() * config_.capacity; }
+    size_t inUse() const { return inUse_; }
+
+private:
+    Config config_;
+    vector<unique_ptr<Order[]>> blocks_;
+    Order *freeList_ = nullptr;
+    size_t inUse_ = 0;
+
+    void grow() {
+        blocks_.emplace_back(new Order[config_.capacity]);
+        Order *block = blocks_.back().get();
+        for(size_t i = config_.capacity; i-- > 0;) {
+            block[i].next = freeList_;
+            freeList_ = &block[i];
+        }
+    }
+};
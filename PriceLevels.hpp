@@ -0,0 +1,303 @@
+#pragma once
+#include "Order.hpp"
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+// Level storage policies for BasicOrderBook. Each policy provides a Side<IsBid>
+// container holding one PriceLevel per tick price, iterated best price first.
+// Level addresses stay stable while the level exists, since orders point back
+// to them.
+
+// Tree-based levels: one std::map node per price.
+struct MapPriceLevels {
+    struct Config {};
+
+    template<bool IsBid>
+    class Side {
+    private:
+        using Compare = conditional_t<IsBid, greater<Price>, less<Price>>;
+        map<Price, PriceLevel, Compare> levels_;
+    public:
+        Side(const Config&, const PriceScale&) {}
+
+        bool empty() const { return levels_.empty(); }
+        Price bestPrice() const { return levels_.begin()->first; }
+        PriceLevel& bestLevel() { return levels_.begin()->second; }
+
+        // True if the best level trades against an opposite order limited at `limit`.
+        bool crosses(Price limit) const {
+            return IsBid ? bestPrice() >= limit : bestPrice() <= limit;
+        }
+
+        PriceLevel* find(Price price) {
+            auto it = levels_.find(price);
+            return it == levels_.end() ? nullptr : &it->second;
+        }
+
+        bool representable(Price) const { return true; }
+
+        // Returns the level for `price`, creating it if needed.
+        PriceLevel* insertLevel(Price price) {
+            PriceLevel &lvl = levels_[price];
+            lvl.price = price;
+            return &lvl;
+        }
+
+        void erase(Price price) { levels_.erase(price); }
+        void clear() {
+            for(auto &kv : levels_)
+                kv.second.clear();
+            levels_.clear();
+        }
+
+        template<typename F>
+        void forEachLevel(F&& f) const {
+            for(auto &kv : levels_)
+                f(kv.first, kv.second);
+        }
+
+        // Like forEachLevel, but stops after the best `n` levels.
+        template<typename F>
+        void forBestLevels(size_t n, F&& f) const {
+            for(auto it = levels_.begin(); it != levels_.end() && n > 0; ++it, --n)
+                f(it->first, it->second);
+        }
+    };
+};
+
+// Two-level bitset over a ladder's ticks: one bit per tick, plus one summary
+// bit per 64-bit word saying whether the word has any bit set. Finding the
+// nearest occupied tick in either direction is a bit scan on at most two
+// words and a short run over the summary (4096 ticks per summary word), so
+// it costs the same however many empty ticks lie in between.
+class OccupancyBitmap {
+public:
+    explicit OccupancyBitmap(size_t bits)
+        : words_((bits + 63) / 64), summary_((words_.size() + 63) / 64) {}
+
+    void set(size_t i) {
+        size_t w = i >> 6;
+        words_[w] |= 1ull << (i & 63);
+        summary_[w >> 6] |= 1ull << (w & 63);
+    }
+
+    void reset(size_t i) {
+        size_t w = i >> 6;
+        words_[w] &= ~(1ull << (i & 63));
+        if(words_[w] == 0)
+            summary_[w >> 6] &= ~(1ull << (w & 63));
+    }
+
+    void clear() {
+        for(uint64_t &s : summary_)
+            s = 0;
+        for(uint64_t &w : words_)
+            w = 0;
+    }
+
+    // Lowest set bit at or above `from`, or -1.
+    long nextAtOrAbove(long from) const {
+        if(from < 0)
+            from = 0;
+        size_t w = static_cast<size_t>(from) >> 6;
+        if(w >= words_.size())
+            return -1;
+        uint64_t bits = words_[w] & (~0ull << (from & 63));
+        if(bits)
+            return static_cast<long>((w << 6) + __builtin_ctzll(bits));
+        if(++w >= words_.size())
+            return -1;
+        size_t s = w >> 6;
+        uint64_t sbits = summary_[s] & (~0ull << (w & 63));
+        if(!sbits) {
+            long next = firstNonZero(s + 1);
+            if(next < 0)
+                return -1;
+            s = static_cast<size_t>(next);
+            sbits = summary_[s];
+        }
+        w = (s << 6) + __builtin_ctzll(sbits);
+        return static_cast<long>((w << 6) + __builtin_ctzll(words_[w]));
+    }
+
+    // Highest set bit at or below `from`, or -1.
+    long nextAtOrBelow(long from) const {
+        if(from < 0)
+            return -1;
+        size_t w = static_cast<size_t>(from) >> 6;
+        if(w >= words_.size()) {
+            w = words_.size() - 1;
+            from = static_cast<long>(w << 6) + 63;
+        }
+        uint64_t bits = words_[w] & (~0ull >> (63 - (from & 63)));
+        if(bits)
+            return static_cast<long>((w << 6) + 63 - __builtin_clzll(bits));
+        if(w == 0)
+            return -1;
+        --w;
+        size_t s = w >> 6;
+        uint64_t sbits = summary_[s] & (~0ull >> (63 - (w & 63)));
+        if(!sbits) {
+            long prev = lastNonZero(static_cast<long>(s) - 1);
+            if(prev < 0)
+                return -1;
+            s = static_cast<size_t>(prev);
+            sbits = summary_[s];
+        }
+        w = (s << 6) + 63 - __builtin_clzll(sbits);
+        return static_cast<long>((w << 6) + 63 - __builtin_clzll(words_[w]));
+    }
+
+private:
+    vector<uint64_t> words_;
+    vector<uint64_t> summary_;
+
+    // First non-zero summary word at or after `s`, or -1. With AVX2 four
+    // words are tested per instruction; the summary is short either way.
+    long firstNonZero(size_t s) const {
+#if defined(__AVX2__)
+        for(; s + 4 <= summary_.size(); s += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&summary_[s]));
+            if(!_mm256_testz_si256(v, v))
+                break;
+        }
+#endif
+        for(; s < summary_.size(); ++s)
+            if(summary_[s])
+                return static_cast<long>(s);
+        return -1;
+    }
+
+    // Last non-zero summary word at or before `s`, or -1.
+    long lastNonZero(long s) const {
+#if defined(__AVX2__)
+        for(; s >= 3; s -= 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&summary_[s - 3]));
+            if(!_mm256_testz_si256(v, v))
+                break;
+        }
+#endif
+        for(; s >= 0; --s)
+            if(summary_[s])
+                return s;
+        return -1;
+    }
+};
+
+// Array-based ladder: levels indexed by tick offset from the bottom of a fixed
+// price band, with the best level index cached and non-empty levels tracked
+// in an OccupancyBitmap. Prices outside the band are not representable.
+struct PriceLadder {
+    struct Config {
+        double minPrice = 0.0;
+        double maxPrice = 1000.0;
+    };
+
+    template<bool IsBid>
+    class Side {
+    private:
+        Price minPrice_;
+        vector<PriceLevel> levels_;
+        OccupancyBitmap bitmap_;    // bit per non-empty level
+        size_t occupied_ = 0;       // number of non-empty levels
+        long best_ = -1;            // index of the best level, -1 when empty
+
+        long indexOf(Price price) const {
+            Price idx = price - minPrice_;
+            if(idx < 0 || idx >= static_cast<Price>(levels_.size()))
+                return -1;
+            return static_cast<long>(idx);
+        }
+        Price priceAt(long idx) const { return minPrice_ + idx; }
+        bool better(long a, long b) const { return IsBid ? a > b : a < b; }
+
+        // The first non-empty level at `idx` or worse, or -1.
+        long nextFrom(long idx) const {
+            return IsBid ? bitmap_.nextAtOrBelow(idx) : bitmap_.nextAtOrAbove(idx);
+        }
+        long worse(long idx) const { return IsBid ? idx - 1 : idx + 1; }
+    public:
+        Side(const Config& cfg, const PriceScale& scale)
+            : minPrice_(scale.toTicks(cfg.minPrice)),
+              levels_(static_cast<size_t>(scale.toTicks(cfg.maxPrice) - minPrice_ + 1)),
+              bitmap_(levels_.size()) {
+            for(size_t i = 0; i < levels_.size(); ++i)
+                levels_[i].price = priceAt(static_cast<long>(i));
+        }
+
+        bool empty() const { return occupied_ == 0; }
+        Price bestPrice() const { return priceAt(best_); }
+        PriceLevel& bestLevel() { return levels_[best_]; }
+
+        bool crosses(Price limit) const {
+            return IsBid ? bestPrice() >= limit : bestPrice() <= limit;
+        }
+
+        PriceLevel* find(Price price) {
+            long idx = indexOf(price);
+            if(idx < 0 || levels_[idx].empty())
+                return nullptr;
+            return &levels_[idx];
+        }
+
+        bool representable(Price price) const { return indexOf(price) >= 0; }
+
+        // Returns the level for `price` (the caller is expected to push into it),
+        // or nullptr if the price lies outside the band.
+        PriceLevel* insertLevel(Price price) {
+            long idx = indexOf(price);
+            if(idx < 0)
+                return nullptr;
+            if(levels_[idx].empty()) {
+                ++occupied_;
+                bitmap_.set(static_cast<size_t>(idx));
+                if(best_ < 0 || better(idx, best_))
+                    best_ = idx;
+            }
+            return &levels_[idx];
+        }
+
+        // Drops a level that has just become empty.
+        void erase(Price price) {
+            long idx = indexOf(price);
+            if(idx < 0)
+                return;
+            --occupied_;
+            bitmap_.reset(static_cast<size_t>(idx));
+            if(idx == best_)
+                best_ = nextFrom(idx);
+        }
+
+        // Only occupied levels hold orders, so only those need clearing.
+        void clear() {
+            for(long i = nextFrom(best_); i >= 0; i = nextFrom(worse(i)))
+                levels_[i].clear();
+            bitmap_.clear();
+            occupied_ = 0;
+            best_ = -1;
+        }
+
+        template<typename F>
+        void forEachLevel(F&& f) const {
+            if(best_ < 0)
+                return;
+            for(long i = best_; i >= 0; i = nextFrom(worse(i)))
+                f(priceAt(i), levels_[i]);
+        }
+
+        template<typename F>
+        void forBestLevels(size_t n, F&& f) const {
+            if(best_ < 0)
+                return;
+            for(long i = best_; i >= 0 && n > 0; i = nextFrom(worse(i)), --n)
+                f(priceAt(i), levels_[i]);
+        }
+    };
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+// Spin-loop hint: lets the sibling hyperthread run while we poll.
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    this_thread::yield();
+#endif
+}
+
+inline size_t roundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while(p < n)
+        p <<= 1;
+    return p;
+}
+
+// Bounded single-producer/single-consumer ring. Capacity is rounded up to a
+// power of two. Several producers may share it if they are serialized by an
+// external lock (the lock hand-off orders their writes).
+template<typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : buffer_(roundUpToPowerOfTwo(capacity)), mask_(buffer_.size() - 1) {}
+
+    bool push(const T &value) {
+        size_t head = head_.load(memory_order_relaxed);
+        if(head - cachedTail_ > mask_) {
+            cachedTail_ = tail_.load(memory_order_acquire);
+            if(head - cachedTail_ > mask_)
+                return false; // full
+        }
+        buffer_[head & mask_] = value;
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        size_t tail = tail_.load(memory_order_relaxed);
+        if(tail == cachedHead_) {
+            cachedHead_ = head_.load(memory_order_acquire);
+            if(tail == cachedHead_)
+                return false; // empty
+        }
+        value = buffer_[tail & mask_];
+        tail_.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        return head_.load(memory_order_acquire) - tail_.load(memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return buffer_.size(); }
+
+private:
+    vector<T> buffer_;
+    size_t mask_;
+    alignas(64) atomic<size_t> head_{0};   // next slot to write
+    size_t cachedTail_ = 0;                // producer's view of tail_
+    alignas(64) atomic<size_t> tail_{0};   // next slot to read
+    size_t cachedHead_ = 0;                // consumer's view of head_
+};
+
+// Bounded multi-producer/single-consumer ring (Vyukov-style per-cell
+// sequence numbers). Producers claim slots with a CAS on head_; the single
+// consumer needs no atomic read-modify-write.
+template<typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity)
+        : cells_(roundUpToPowerOfTwo(capacity)), mask_(cells_.size() - 1) {
+        for(size_t i = 0; i < cells_.size(); ++i)
+            cells_[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    bool push(const T &value) {
+        size_t pos = head_.load(memory_order_relaxed);
+        for(;;) {
+            Cell &cell = cells_[pos & mask_];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if(diff == 0) {
+                if(head_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                    break;
+            } else if(diff < 0) {
+                return false; // full
+            } else {
+                pos = head_.load(memory_order_relaxed);
+            }
+        }
+        Cell &cell = cells_[pos & mask_];
+        cell.value = value;
+        cell.sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    bool pop(T &value) {
+        Cell &cell = cells_[tail_ & mask_];
+        if(cell.sequence.load(memory_order_acquire) != tail_ + 1)
+            return false; // empty, or the producer has not finished writing
+        value = cell.value;
+        cell.sequence.store(tail_ + mask_ + 1, memory_order_release);
+        ++tail_;
+        return true;
+    }
+
+    // Consumer side only.
+    bool empty() const {
+        return cells_[tail_ & mask_].sequence.load(memory_order_acquire) != tail_ + 1;
+    }
+
+    size_t capacity() const { return cells_.size(); }
+
+private:
+    struct Cell {
+        atomic<size_t> sequence{0};
+        T value{};
+    };
+    vector<Cell> cells_;
+    size_t mask_;
+    alignas(64) atomic<size_t> head_{0};
+    alignas(64) size_t tail_ = 0;   // consumer only
+};
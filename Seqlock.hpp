@@ -0,0 +1,57 @@
+#pragma once
+#include "Ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+using namespace std;
+
+// Single-writer, many-reader sequence lock around a small trivially copyable
+// value. The writer never waits; readers never write shared state, so any
+// number of them can poll without slowing the writer beyond cache traffic.
+// The value is stored as relaxed atomic words, so a torn read is detected by
+// the sequence check rather than being a data race.
+template<typename T>
+class Seqlock {
+    static_assert(is_trivially_copyable<T>::value, "Seqlock value must be trivially copyable");
+    static constexpr size_t wordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+public:
+    Seqlock() { write(T{}); }
+
+    // Only one thread may write at a time (e.g. under the owner's lock).
+    void write(const T &value) {
+        uint64_t words[wordCount] = {};
+        memcpy(words, &value, sizeof(T));
+        uint64_t seq = sequence_.load(memory_order_relaxed);
+        sequence_.store(seq + 1, memory_order_relaxed);   // odd: write in progress
+        atomic_thread_fence(memory_order_release);
+        for(size_t i = 0; i < wordCount; ++i)
+            words_[i].store(words[i], memory_order_relaxed);
+        sequence_.store(seq + 2, memory_order_release);
+    }
+
+    // Returns a consistent copy, retrying while a write overlaps the read.
+    T read() const {
+        uint64_t words[wordCount];
+        for(;;) {
+            uint64_t before = sequence_.load(memory_order_acquire);
+            if(before & 1) {
+                cpuRelax();
+                continue;
+            }
+            for(size_t i = 0; i < wordCount; ++i)
+                words[i] = words_[i].load(memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            if(sequence_.load(memory_order_relaxed) == before)
+                break;
+        }
+        T value;
+        memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    alignas(64) atomic<uint64_t> sequence_{0};
+    atomic<uint64_t> words_[wordCount];
+};
@@ -0,0 +1,190 @@
+#pragma once
+#include "MatchingEngine.hpp"
+#include <vector>
+#include <memory>
+using namespace std;
+
+// Multi-instrument engine: one single-writer book per symbol, with symbols
+// partitioned across a fixed set of matching threads (shards). Symbol s lives
+// on shard s % shardCount and only that shard's thread ever touches its book,
+// so shards share nothing but the producers' view of their inbound rings.
+// Commands for one symbol are applied in submission order (per producer);
+// across shards there is no global order.
+
+struct ShardedEngineConfig {
+    size_t symbolCount = 1024;      // symbols are 0 .. symbolCount-1
+    size_t shardCount = 1;          // matching threads
+    vector<int> cpus;               // core per shard; shards past the end stay unpinned
+    size_t inboundCapacity = 1 << 16;   // per shard
+    size_t outboundCapacity = 1 << 16;  // per shard
+    WaitMode waitMode = WaitMode::BusySpin;
+    // Per-book sizing: thousands of books are resident at once, so start small and grow.
+    OrderPoolConfig pool{1 << 8, true};
+    OrderIndexConfig index{1 << 16, 1 << 8, 64};
+};
+
+template<typename Levels = MapPriceLevels>
+class BasicShardedEngine {
+public:
+    using Book = BasicOrderBook<Levels, NullMutex>;
+
+    explicit BasicShardedEngine(const ShardedEngineConfig &config = {}, const PriceScale &scale = {},
+                                const typename Levels::Config &levels = {})
+        : config_(config) {
+        if(config_.shardCount == 0)
+            config_.shardCount = 1;
+        for(size_t i = 0; i < config_.shardCount; ++i) {
+            int cpu = i < config_.cpus.size() ? config_.cpus[i] : -1;
+            shards_.emplace_back(new Shard(config_, cpu));
+        }
+        books_.reserve(config_.symbolCount);
+        for(size_t s = 0; s < config_.symbolCount; ++s)
+            books_.emplace_back(new Book(scale, levels, config_.pool, WaitMode::BusySpin, config_.index));
+        for(size_t s = 0; s < config_.symbolCount; ++s)
+            shards_[s % shards_.size()]->books.push_back(books_[s].get());
+    }
+
+    ~BasicShardedEngine() { stop(); }
+
+    BasicShardedEngine(const BasicShardedEngine&) = delete;
+    BasicShardedEngine& operator=(const BasicShardedEngine&) = delete;
+
+    void start() {
+        for(auto &shard : shards_)
+            shard->start();
+    }
+
+    // Applies every command already submitted, then joins all shard threads.
+    // A result that does not fit in its shard's full outbound ring once stop
+    // has begun is dropped rather than hang the join; droppedResults() counts them.
+    void stop() {
+        for(auto &shard : shards_)
+            shard->stop();
+    }
+
+    // Safe from any number of threads. Returns false for an unknown symbol or
+    // if the owning shard's inbound ring is full.
+    bool submit(const Command &command) {
+        if(command.symbol >= books_.size())
+            return false;
+        return shards_[shardOf(command.symbol)]->submit(command);
+    }
+
+    // Single consumer across all shards; polls them in turn. Results are
+    // only complete if droppedResults() is 0 (see stop()).
+    bool pollResult(CommandResult &result) {
+        for(size_t n = 0; n < shards_.size(); ++n) {
+            Shard &shard = *shards_[nextPoll_];
+            nextPoll_ = nextPoll_ + 1 == shards_.size() ? 0 : nextPoll_ + 1;
+            if(shard.outbound.pop(result))
+                return true;
+        }
+        return false;
+    }
+
+    size_t shardCount() const { return shards_.size(); }
+    size_t symbolCount() const { return books_.size(); }
+    size_t shardOf(uint32_t symbol) const { return symbol % shards_.size(); }
+
+    // Direct access to a symbol's book; only safe while the engine is stopped.
+    Book& book(uint32_t symbol) { return *books_[symbol]; }
+
+    uint64_t processed() const {
+        uint64_t total = 0;
+        for(auto &shard : shards_)
+            total += shard->sequence.load(memory_order_acquire);
+        return total;
+    }
+
+    // Results discarded because an outbound ring was full during stop().
+    uint64_t droppedResults() const {
+        uint64_t total = 0;
+        for(auto &shard : shards_)
+            total += shard->dropped.load(memory_order_relaxed);
+        return total;
+    }
+
+private:
+    // One matching thread and the rings feeding it. CommandResult::sequence
+    // is the command's position in its shard's order.
+    struct Shard {
+        MpscRing<Command> inbound;
+        SpscRing<CommandResult> outbound;
+        WaitStrategy wait;
+        int cpu;
+        size_t shardCount;
+        vector<Book*> books;    // indexed by symbol / shardCount
+        atomic<bool> running{false};
+        atomic<uint64_t> sequence{0};
+        atomic<uint64_t> dropped{0};
+        thread worker;
+
+        Shard(const ShardedEngineConfig &config, int cpu)
+            : inbound(config.inboundCapacity), outbound(config.outboundCapacity),
+              wait(config.waitMode), cpu(cpu), shardCount(config.shardCount) {}
+
+        void start() {
+            running = true;
+            worker = thread(&Shard::run, this);
+        }
+
+        void stop() {
+            running = false;
+            wait.notify();
+            if(worker.joinable())
+                worker.join();
+        }
+
+        bool submit(const Command &command) {
+            if(!inbound.push(command))
+                return false;
+            wait.notify();
+            return true;
+        }
+
+        void run() {
+            pinCurrentThread(cpu);
+            Command command;
+            unsigned spins = 0;
+            auto ready = [this]{ return !inbound.empty() || !running; };
+            for(;;) {
+                // Sampled before the poll, so a command submitted just before
+                // stop() is still popped on the pass after the flag flips.
+                bool stopping = !running;
+                if(inbound.pop(command)) {
+                    apply(command);
+                    spins = 0;
+                } else if(stopping) {
+                    break;
+                } else {
+                    wait.idle(spins, ready);
+                }
+            }
+        }
+
+        void apply(const Command &command) {
+            CommandResult result;
+            result.symbol = command.symbol;
+            result.type = command.type;
+            result.orderId = command.orderId;
+            result.accepted = applyCommand(*books[command.symbol / shardCount], command);
+            result.sequence = sequence.load(memory_order_relaxed) + 1;
+            sequence.store(result.sequence, memory_order_release);
+            // Back-pressure on the result consumer, but never hang a stopping shard.
+            while(!outbound.push(result)) {
+                if(!running) {
+                    dropped.fetch_add(1, memory_order_relaxed);
+                    return;
+                }
+                cpuRelax();
+            }
+        }
+    };
+
+    ShardedEngineConfig config_;
+    vector<unique_ptr<Shard>> shards_;
+    vector<unique_ptr<Book>> books_;
+    size_t nextPoll_ = 0;
+};
+
+using ShardedEngine = BasicShardedEngine<MapPriceLevels>;
@@ -0,0 +1,221 @@
+#pragma once
+#include "Order.hpp"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+// Binary image of one book's full state: a header, then every resting order
+// (bids then asks, best level first, queue order within a level), then every
+// pending stop in election order. Entries are fixed-size, so a mapped file is
+// used in place without parsing. POSIX only.
+
+struct SnapshotHeader {
+    char magic[8] = {'O', 'B', 'S', 'N', 'A', 'P', '0', '1'};
+    uint32_t version = 1;
+    uint32_t entrySize = 32;
+    uint64_t sequence = 0;      // engine sequence of the last command reflected
+    uint64_t orderCount = 0;
+    uint64_t stopCount = 0;
+    uint64_t arrivals = 0;      // the book's arrival counter (Order::timestamp source)
+    Price lastTradePrice = 0;
+    double tickSize = 0.0;
+    uint8_t traded = 0;
+    uint8_t reserved[7] = {};
+};
+
+// A resting order (price = limit) or a pending stop (price = trigger).
+struct SnapshotEntry {
+    Price price = 0;
+    uint64_t timestamp = 0;
+    int32_t orderId = 0;
+    int32_t quantity = 0;
+    Side side = Side::Buy;
+    OrderType orderType = OrderType::Limit;
+    uint8_t reserved[6] = {};
+};
+
+static_assert(sizeof(SnapshotHeader) == 72, "snapshot header layout");
+static_assert(sizeof(SnapshotEntry) == 32, "snapshot entry layout");
+
+// A captured snapshot held in memory; entries are the orders then the stops.
+struct BookSnapshot {
+    SnapshotHeader header;
+    vector<SnapshotEntry> entries;
+};
+
+// Syncs the directory holding `path`, making a rename into it durable.
+inline bool syncParentDirectory(const string &path) {
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if(fd < 0)
+        return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+// Writes `snapshot` to `path` atomically: a temporary file is synced, renamed
+// over the old one and the directory synced, so a crash leaves either
+// snapshot intact.
+inline bool writeSnapshot(const string &path, const BookSnapshot &snapshot) {
+    string tmp = path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        return false;
+    auto writeAll = [fd](const void *data, size_t size) {
+        const char *p = static_cast<const char*>(data);
+        while(size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if(n <= 0)
+                return false;
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+    bool ok = writeAll(&snapshot.header, sizeof(snapshot.header)) &&
+              writeAll(snapshot.entries.data(), snapshot.entries.size() * sizeof(SnapshotEntry)) &&
+              fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    if(!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return syncParentDirectory(path);
+}
+
+// Read-only mapping of a snapshot file; header() and entries() point into the
+// mapping.
+class MappedSnapshot {
+public:
+    MappedSnapshot() = default;
+    ~MappedSnapshot() { close(); }
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    // Returns false if the file is missing, truncated or not a snapshot.
+    bool open(const string &path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void *map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(map == MAP_FAILED)
+            return false;
+        map_ = map;
+        const SnapshotHeader &h = header();
+        SnapshotHeader expected;
+        if(memcmp(h.magic, expected.magic, sizeof(h.magic)) != 0 || h.version != expected.version ||
+           h.entrySize != sizeof(SnapshotEntry) ||
+           size_ != sizeof(SnapshotHeader) + (h.orderCount + h.stopCount) * sizeof(SnapshotEntry)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if(map_ != nullptr)
+            munmap(map_, size_);
+        map_ = nullptr;
+        size_ = 0;
+    }
+
+    const SnapshotHeader& header() const { return *static_cast<const SnapshotHeader*>(map_); }
+    const SnapshotEntry* entries() const {
+        return reinterpret_cast<const SnapshotEntry*>(static_cast<const char*>(map_) + sizeof(SnapshotHeader));
+    }
+
+private:
+    void *map_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Background thread that writes captured snapshots, so the matching thread
+// only pays for the in-memory copy. It holds one snapshot at a time; a
+// capture offered while the previous one is still being written is refused.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(string path) : path_(move(path)) {}
+    ~SnapshotWriter() { stop(); }
+
+    void start() {
+        running_ = true;
+        thread_ = thread(&SnapshotWriter::run, this);
+    }
+
+    // Finishes any snapshot in flight, then joins.
+    void stop() {
+        {
+            lock_guard<mutex> lock(mtx_);
+            running_ = false;
+        }
+        cv_.notify_all();
+        if(thread_.joinable())
+            thread_.join();
+    }
+
+    bool busy() const { return busy_.load(memory_order_acquire); }
+
+    // Takes ownership of `snapshot` unless the writer is busy.
+    bool submit(BookSnapshot &&snapshot) {
+        if(busy())
+            return false;
+        {
+            lock_guard<mutex> lock(mtx_);
+            pending_ = move(snapshot);
+            busy_.store(true, memory_order_release);
+        }
+        cv_.notify_all();
+        return true;
+    }
+
+    uint64_t written() const { return written_.load(memory_order_relaxed); }
+    uint64_t errors() const { return errors_.load(memory_order_relaxed); }
+
+private:
+    string path_;
+    BookSnapshot pending_;
+    mutex mtx_;
+    condition_variable cv_;
+    bool running_ = false;
+    atomic<bool> busy_{false};
+    atomic<uint64_t> written_{0};
+    atomic<uint64_t> errors_{0};
+    thread thread_;
+
+    void run() {
+        unique_lock<mutex> lock(mtx_);
+        for(;;) {
+            cv_.wait(lock, [this]{ return busy() || !running_; });
+            if(busy()) {
+                lock.unlock();
+                bool ok = writeSnapshot(path_, pending_);
+                (ok ? written_ : errors_).fetch_add(1, memory_order_relaxed);
+                lock.lock();
+                busy_.store(false, memory_order_release);
+            } else if(!running_) {
+                return;
+            }
+        }
+    }
+};
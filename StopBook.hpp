@@ -0,0 +1,117 @@
+#pragma once
+#include "Order.hpp"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <cstdint>
+using namespace std;
+
+// A resting stop order, waiting for its trigger price to be reached.
+struct StopOrder {
+    int orderId = 0;
+    Price stopPrice = 0;
+    int quantity = 0;
+    bool buy = true;
+    uint64_t sequence = 0;  // arrival order, for time priority among equal triggers
+};
+
+// Stop orders indexed by trigger price. Buy stops fire when the price rises to
+// their trigger, so they are kept ascending; sell stops fire when it falls, so
+// they are kept descending. Either way the stops crossed by a price move form
+// a prefix of their side, found in O(log n) and removed in O(k). Equal
+// triggers keep arrival order. Not thread-safe: the owning book calls it
+// under its own lock.
+class StopBook {
+public:
+    // Returns false if `orderId` is already resting here.
+    bool add(int orderId, Price stopPrice, int quantity, bool buy) {
+        if(!index_.emplace(orderId, Location{stopPrice, buy}).second)
+            return false;
+        StopOrder stop{orderId, stopPrice, quantity, buy, ++sequence_};
+        if(buy)
+            buys_.emplace(stopPrice, stop);
+        else
+            sells_.emplace(stopPrice, stop);
+        return true;
+    }
+
+    // Removes a resting stop; `removed` receives it. Returns false if not found.
+    bool cancel(int orderId, StopOrder &removed) {
+        auto found = index_.find(orderId);
+        if(found == index_.end())
+            return false;
+        Location loc = found->second;
+        index_.erase(found);
+        if(loc.buy)
+            removed = eraseFrom(buys_, loc.stopPrice, orderId);
+        else
+            removed = eraseFrom(sells_, loc.stopPrice, orderId);
+        return true;
+    }
+
+    // Moves buy stops with a trigger at or below `price` to `out`, lowest
+    // trigger first.
+    void electBuys(Price price, vector<StopOrder> &out) {
+        electFrom(buys_, buys_.upper_bound(price), out);
+    }
+
+    // Moves sell stops with a trigger at or above `price` to `out`, highest
+    // trigger first.
+    void electSells(Price price, vector<StopOrder> &out) {
+        electFrom(sells_, sells_.upper_bound(price), out);
+    }
+
+    // Calls f(const StopOrder&) for every stop in election order: buys, then sells.
+    template<typename F>
+    void forEach(F &&f) const {
+        for(auto &kv : buys_)
+            f(kv.second);
+        for(auto &kv : sells_)
+            f(kv.second);
+    }
+
+    bool contains(int orderId) const { return index_.count(orderId) != 0; }
+    size_t size() const { return index_.size(); }
+    bool empty() const { return index_.empty(); }
+    bool hasBuys() const { return !buys_.empty(); }
+    bool hasSells() const { return !sells_.empty(); }
+
+    void clear() {
+        buys_.clear();
+        sells_.clear();
+        index_.clear();
+    }
+
+private:
+    struct Location {
+        Price stopPrice;
+        bool buy;
+    };
+
+    multimap<Price, StopOrder> buys_;
+    multimap<Price, StopOrder, greater<Price>> sells_;
+    unordered_map<int, Location> index_;
+    uint64_t sequence_ = 0;
+
+    template<typename Map>
+    static StopOrder eraseFrom(Map &side, Price stopPrice, int orderId) {
+        auto range = side.equal_range(stopPrice);
+        for(auto it = range.first; it != range.second; ++it) {
+            if(it->second.orderId == orderId) {
+                StopOrder stop = it->second;
+                side.erase(it);
+                return stop;
+            }
+        }
+        return StopOrder{};
+    }
+
+    template<typename Map>
+    void electFrom(Map &side, typename Map::iterator end, vector<StopOrder> &out) {
+        for(auto it = side.begin(); it != end; it = side.erase(it)) {
+            out.push_back(it->second);
+            index_.erase(it->second.orderId);
+        }
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include "Ring.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+// How a consumer loop idles when its queue is empty.
+enum class WaitMode {
+    BusySpin,       // spin with a pause hint; lowest latency, burns a core
+    SpinThenYield,  // spin briefly, then yield the CPU between polls
+    Blocking        // spin briefly, then sleep until a producer signals
+};
+
+// Idle policy shared by one queue's consumers and producers. Consumers call
+// idle() after a missed poll and reset their spin count after doing work;
+// producers call notify() after publishing.
+class WaitStrategy {
+public:
+    static constexpr unsigned spinLimit = 100;
+
+    explicit WaitStrategy(WaitMode mode = WaitMode::Blocking) : mode_(mode) {}
+
+    WaitMode mode() const { return mode_; }
+
+    // `ready` reports whether there is work (or a reason to stop) so a
+    // blocking consumer does not sleep through a wakeup.
+    template<typename Ready>
+    void idle(unsigned &spins, Ready &&ready) {
+        if(mode_ == WaitMode::BusySpin || spins < spinLimit) {
+            ++spins;
+            cpuRelax();
+            return;
+        }
+        if(mode_ == WaitMode::SpinThenYield) {
+            this_thread::yield();
+            return;
+        }
+        unique_lock<mutex> lock(mtx_);
+        sleepers_.fetch_add(1);
+        // Pairs with the fence in notify(): either we see the producer's item
+        // or it sees us as a sleeper.
+        atomic_thread_fence(memory_order_seq_cst);
+        cv_.wait(lock, ready);
+        sleepers_.fetch_sub(1);
+        spins = 0;
+    }
+
+    void notify() {
+        if(mode_ != WaitMode::Blocking)
+            return;
+        atomic_thread_fence(memory_order_seq_cst);
+        if(sleepers_.load(memory_order_relaxed) == 0)
+            return;
+        lock_guard<mutex> lock(mtx_);
+        cv_.notify_all();
+    }
+
+private:
+    WaitMode mode_;
+    mutex mtx_;
+    condition_variable cv_;
+    atomic<int> sleepers_{0};
+};
@@ -0,0 +1,396 @@
+// microbenchmarks for individual OrderBook operations (Google Benchmark)
+// build: g++ bench_orderbook.cpp -std=c++17 -O2 -lbenchmark -ltbb -lpthread -o bench_orderbook
+// run:   ./bench_orderbook [--benchmark_filter=<regex>]
+//
+// Every benchmark runs on a single-writer book (no lock, no processor queues)
+// pre-filled with `depth` price levels per side and `perLevel` orders per level,
+// so the numbers isolate the book's data structures. Time is per operation;
+// items_per_second is ops/s. The book is rebuilt with the timer paused
+// whenever an operation would change the shape being measured.
+// BM_ShardedThroughput is the exception: it drives the multi-symbol engine
+// end to end and reports wall-clock commands/s per shard count. So is
+// BM_JournalReplay, which rebuilds a book from a journal file. BM_AddCancelBatch
+// uses the locking book, since batching exists to save its lock round trips.
+#include "OrderBook.hpp"
+#include "ShardedEngine.hpp"
+#include "Journal.hpp"
+#include "LatencyHistogram.hpp"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+
+const double kMid = 100.0;
+const double kTick = 0.01;
+const int kOrderQty = 100;
+
+template<typename Levels>
+struct BookFixture
+{
+    using Book = BasicOrderBook<Levels, NullMutex>;
+
+    Book book{PriceScale{kTick}};
+    int depth;
+    int perLevel;
+    int nextId = 1;
+    vector<vector<int>> askIds; // [level][queue position]
+
+    BookFixture(int d, int k) : depth(d), perLevel(k) { build(); }
+
+    static double askPrice(int level) { return kMid + (level + 1) * kTick; }
+    static double bidPrice(int level) { return kMid - (level + 1) * kTick; }
+
+    void build()
+    {
+        book.reset();
+        askIds.assign(depth, vector<int>());
+        for(int level = 0; level < depth; level++)
+            for(int i = 0; i < perLevel; i++)
+            {
+                int askId = nextId++;
+                askIds[level].push_back(askId);
+                book.addOrder(askId, askPrice(level), kOrderQty, "sell", OrderType::Limit);
+                book.addOrder(nextId++, bidPrice(level), kOrderQty, "buy", OrderType::Limit);
+            }
+    }
+
+    void rebuild(benchmark::State &state)
+    {
+        state.PauseTiming();
+        build();
+        state.ResumeTiming();
+    }
+};
+
+void setCounters(benchmark::State &state)
+{
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<typename Levels>
+void BM_AddLimitExistingLevel(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int added = 0;
+    for(auto _ : state)
+    {
+        if(added == 1000) { f.rebuild(state); added = 0; }
+        f.book.addOrder(f.nextId++, f.bidPrice(0), kOrderQty, "buy", OrderType::Limit);
+        added++;
+    }
+    setCounters(state);
+}
+
+template<typename Levels>
+void BM_AddLimitNewLevel(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int added = 0;
+    for(auto _ : state)
+    {
+        if(added == 1000) { f.rebuild(state); added = 0; }
+        // each order opens a fresh level just outside the existing book
+        f.book.addOrder(f.nextId++, f.bidPrice(f.depth + added), kOrderQty, "buy", OrderType::Limit);
+        added++;
+    }
+    setCounters(state);
+}
+
+// position: 0 = front of the level, 1 = middle, 2 = back
+template<typename Levels>
+void BM_Cancel(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int position = state.range(2);
+    int slot = position == 0 ? 0 : position == 1 ? f.perLevel / 2 : f.perLevel - 1;
+    int level = 0;
+    for(auto _ : state)
+    {
+        if(level == f.depth) { f.rebuild(state); level = 0; }
+        f.book.cancelOrder(f.askIds[level][slot]);
+        level++;
+    }
+    setCounters(state);
+}
+
+template<typename Levels>
+void BM_Modify(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int slot = f.perLevel / 2;
+    int level = 0;
+    for(auto _ : state)
+    {
+        if(level == f.depth) { f.rebuild(state); level = 0; }
+        f.book.modifyOrder(f.askIds[level][slot], kOrderQty / 2, f.askPrice(level));
+        level++;
+    }
+    setCounters(state);
+}
+
+// market buy sized to take out `levels` whole ask levels
+template<typename Levels>
+void BM_MarketSweep(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int levels = state.range(2);
+    int qty = levels * f.perLevel * kOrderQty;
+    int remaining = f.depth;
+    for(auto _ : state)
+    {
+        if(remaining < levels) { f.rebuild(state); remaining = f.depth; }
+        f.book.addOrder(f.nextId++, 0, qty, "buy", OrderType::Market);
+        remaining -= levels;
+    }
+    setCounters(state);
+}
+
+// IOC buy for one lot at the touch: a partial fill of the front order
+template<typename Levels>
+void BM_IOC(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    int sent = 0;
+    for(auto _ : state)
+    {
+        if(sent == 1000) { f.rebuild(state); sent = 0; }
+        f.book.addOrder(f.nextId++, f.askPrice(f.depth), 1, "buy", OrderType::IOC);
+        sent++;
+    }
+    setCounters(state);
+}
+
+template<typename Levels>
+void BM_BestBidAsk(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    for(auto _ : state)
+    {
+        benchmark::DoNotOptimize(f.book.getBestBid());
+        benchmark::DoNotOptimize(f.book.getBestAsk());
+    }
+    setCounters(state);
+}
+
+// a buy stop at the current ask: elected on arrival and executed as a one-lot
+// market order, with depth x perLevel other stops resting far from the market
+template<typename Levels>
+void BM_StopTrigger(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    auto restStops = [&f] {
+        for(int i = 0; i < f.depth * f.perLevel; i++)
+            f.book.addStopOrder(f.nextId++, f.askPrice(f.depth + i), 1, "buy");
+    };
+    restStops();
+    int sent = 0;
+    for(auto _ : state)
+    {
+        if(sent == 1000)
+        {
+            state.PauseTiming();
+            f.build();
+            restStops();
+            state.ResumeTiming();
+            sent = 0;
+        }
+        f.book.addStopOrder(f.nextId++, f.askPrice(0), 1, "buy");
+        sent++;
+    }
+    setCounters(state);
+}
+
+// per-operation latency distribution for a passive add followed by its cancel;
+// reports tail percentiles as counters alongside the mean time
+template<typename Levels>
+void BM_AddCancelLatency(benchmark::State &state)
+{
+    BookFixture<Levels> f(state.range(0), state.range(1));
+    LatencyHistogram addLatency, cancelLatency;
+    for(auto _ : state)
+    {
+        int id = f.nextId++;
+        auto t0 = chrono::steady_clock::now();
+        f.book.addOrder(id, f.bidPrice(0), kOrderQty, "buy", OrderType::Limit);
+        auto t1 = chrono::steady_clock::now();
+        f.book.cancelOrder(id);
+        auto t2 = chrono::steady_clock::now();
+        addLatency.record(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count());
+        cancelLatency.record(chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count());
+    }
+    state.counters["add_p50"] = addLatency.percentile(50);
+    state.counters["add_p99"] = addLatency.percentile(99);
+    state.counters["add_p99.9"] = addLatency.percentile(99.9);
+    state.counters["add_p99.99"] = addLatency.percentile(99.99);
+    state.counters["cancel_p50"] = cancelLatency.percentile(50);
+    state.counters["cancel_p99.9"] = cancelLatency.percentile(99.9);
+    state.counters["cancel_max"] = cancelLatency.max();
+    setCounters(state);
+}
+
+// batches of crossing buy/sell pairs spread round-robin over 1024 symbols,
+// submitted and drained by the benchmark thread; each batch leaves the books
+// empty again
+void BM_ShardedThroughput(benchmark::State &state)
+{
+    const uint32_t symbols = 1024;
+    const int batch = 1 << 14;
+    ShardedEngineConfig config;
+    config.symbolCount = symbols;
+    config.shardCount = state.range(0);
+    config.waitMode = WaitMode::SpinThenYield;
+    ShardedEngine engine(config);
+    vector<Command> commands(batch);
+    for(int i = 0; i < batch; i++)
+    {
+        Command &c = commands[i];
+        c.symbol = (i / 2) % symbols;
+        c.orderId = i / 2 / symbols * 2 + i % 2 + 1;
+        c.buy = i % 2 == 0;
+        c.price = kMid;
+        c.quantity = kOrderQty;
+    }
+    engine.start();
+    CommandResult result;
+    for(auto _ : state)
+    {
+        int received = 0;
+        for(const Command &c : commands)
+            while(!engine.submit(c))
+                if(engine.pollResult(result)) received++;
+        while(received < batch)
+            if(engine.pollResult(result)) received++;
+    }
+    engine.stop();
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+
+// recovery speed: a journal of `range(0)` commands (rests, partial fills and
+// cancels around the touch) replayed into a fresh book, as start() does
+void BM_JournalReplay(benchmark::State &state)
+{
+    const int commands = state.range(0);
+    string path = "/tmp/bench_orderbook_journal.bin";
+    unlink(path.c_str());
+    {
+        Journal journal;
+        journal.open(path, false);
+        Command c;
+        c.quantity = kOrderQty;
+        for(int i = 0; i < commands; i++)
+        {
+            int id = i / 3 + 1;
+            switch(i % 3)
+            {
+                case 0: c.type = CommandType::Add; c.orderId = id; c.buy = id % 2; c.price = kMid + (id % 2 ? -1 : 1) * (id % 50) * kTick; break;
+                case 1: c.type = CommandType::Add; c.orderId = -id; c.buy = !(id % 2); c.price = kMid; c.quantity = 1; break;
+                case 2: c.type = CommandType::Cancel; c.orderId = id; c.quantity = kOrderQty; break;
+            }
+            journal.append(i + 1, c);
+        }
+        journal.close();
+    }
+    for(auto _ : state)
+    {
+        state.PauseTiming();
+        {
+            BasicOrderBook<MapPriceLevels, NullMutex> book{PriceScale{kTick}};
+            state.ResumeTiming();
+            long long n = Journal::replay(path, [&book](const JournalRecord &record) {
+                applyCommand(book, record.command());
+            });
+            benchmark::DoNotOptimize(n);
+            state.PauseTiming();
+        }
+        state.ResumeTiming();
+    }
+    unlink(path.c_str());
+    state.SetItemsProcessed(state.iterations() * commands);
+}
+
+// `batch` non-crossing limit adds, then cancels of the same IDs, either one
+// call per order or one addOrders/cancelOrders call per batch; the processor
+// threads run, as they would in production
+void BM_AddCancelBatch(benchmark::State &state)
+{
+    const int batch = state.range(0);
+    const bool batched = state.range(1);
+    OrderBook book{PriceScale{kTick}};
+    thread buyThread(&OrderBook::processBuyOrders, &book);
+    thread sellThread(&OrderBook::processSellOrders, &book);
+    vector<OrderRequest> adds(batch);
+    vector<int> ids(batch);
+    unique_ptr<bool[]> ok(new bool[batch]);
+    int nextId = 1;
+    for(auto _ : state)
+    {
+        for(int i = 0; i < batch; i++)
+        {
+            OrderRequest &r = adds[i];
+            r.orderId = ids[i] = nextId++;
+            r.side = i % 2 ? Side::Buy : Side::Sell;
+            r.price = kMid + (i % 2 ? -1 : 1) * (1 + i % 10) * kTick;
+            r.quantity = kOrderQty;
+        }
+        if(batched)
+        {
+            book.addOrders(adds.data(), batch, ok.get());
+            book.cancelOrders(ids.data(), batch, ok.get());
+        }
+        else
+        {
+            for(const OrderRequest &r : adds)
+                book.addOrder(r.orderId, r.price, r.quantity, r.side, r.orderType);
+            for(int id : ids)
+                book.cancelOrder(id);
+        }
+    }
+    book.stopProcessing();
+    buyThread.join();
+    sellThread.join();
+    state.SetItemsProcessed(state.iterations() * batch * 2);
+}
+
+// depth x orders per level
+void bookShapes(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"depth", "perLevel"});
+    b->ArgsProduct({{10, 100, 1000}, {1, 16}});
+}
+
+void cancelShapes(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"depth", "perLevel", "position"});
+    b->ArgsProduct({{10, 1000}, {1, 16, 256}, {0, 1, 2}});
+}
+
+void sweepShapes(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"depth", "perLevel", "levels"});
+    b->ArgsProduct({{100, 1000}, {1, 16}, {1, 10, 50}});
+}
+
+} // namespace
+
+#define BOOK_BENCHMARK(fn, shapes) \
+    BENCHMARK_TEMPLATE(fn, MapPriceLevels)->Apply(shapes); \
+    BENCHMARK_TEMPLATE(fn, PriceLadder)->Apply(shapes)
+
+BOOK_BENCHMARK(BM_AddLimitExistingLevel, bookShapes);
+BOOK_BENCHMARK(BM_AddLimitNewLevel, bookShapes);
+BOOK_BENCHMARK(BM_Cancel, cancelShapes);
+BOOK_BENCHMARK(BM_Modify, bookShapes);
+BOOK_BENCHMARK(BM_MarketSweep, sweepShapes);
+BOOK_BENCHMARK(BM_IOC, bookShapes);
+BOOK_BENCHMARK(BM_BestBidAsk, bookShapes);
+BOOK_BENCHMARK(BM_StopTrigger, bookShapes);
+BOOK_BENCHMARK(BM_AddCancelLatency, bookShapes);
+BENCHMARK(BM_AddCancelBatch)->ArgNames({"batch", "batched"})->ArgsProduct({{64}, {0, 1}});
+BENCHMARK(BM_JournalReplay)->ArgName("commands")->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ShardedThroughput)->ArgName("shards")->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -15,30 +15,19 @@
 #include <functional>
 
 #include "OrderBook.hpp"
-#include "StopOrderScheduler.hpp"
 using namespace std;
 
 void testStopOrder(OrderBook& ob)
 {
     cout << "Test Stop Order\n";
     ob.reset();
-    //setup StopOrderScheduler w/ reference to order book
-    StopOrderScheduler stopScheduler(ob);
-    //start the scheduler in its own thread
-    thread schedulerThread(&StopOrderScheduler::run, &stopScheduler);
     //add a stop order. Ex: buy stop order will be triggered when the best ask>=stopPrice, here we use the example of the stopPrice=150
-    OrderPointer stopOrder=make_shared<Order>(Order{OrderType::Stop, 30, 140, 10, "buy", 150});
-    stopScheduler.addStopOrder(stopOrder);
+    //stops are checked by the book itself after every trade or quote change, no scheduler thread needed
+    ob.addStopOrder(30, 150, 10, "buy");
 
-    //add an opposing sell order that raises the best ask ti 150
+    //add an opposing sell order that raises the best ask to 155 and triggers the stop
     ob.addOrder(31, 155, 10, "sell", OrderType::Limit);
-
-    //allow some time for the scheduler to trigger the stop order
-    this_thread::sleep_for(chrono::seconds(2));
-
-    //stop the scheduler and join the thread
-    stopScheduler.stop();
-    schedulerThread.join();
+    this_thread::sleep_for(chrono::seconds(1));
 
     ob.displayOrders();
     cout << "Best Bid: " << ob.getBestBid() << ", Best Ask: " << ob.getBestAsk() << '\n';
@@ -117,6 +106,13 @@ void runTestScenarios(OrderBook& ob) {
 
 int main() {
     OrderBook orderBook;
+
+    // Book events are formatted to stdout by a background logger thread.
+    EventRing events;
+    TextEventSink console(cout, orderBook.priceScale());
+    EventLogger logger(events, console);
+    orderBook.setEventRing(&events);
+    logger.start();
     
     // Start simulated processing threads
     thread buyConsumer(&OrderBook::processBuyOrders, &orderBook);
@@ -137,6 +133,7 @@ int main() {
     buyConsumer.join();
     sellConsumer.join();
     
+    logger.stop();
     cout << "Final Order Book:" << endl;
     orderBook.displayOrders();
     cout << "Final Best Bid: " << orderBook.getBestBid()
@@ -1,61 +1,49 @@
 // using catch2 to do unit testing for concurrency
 #define CATCH_CONFIG_MAIN
 #include "OrderBook.hpp"
+#include "MatchingEngine.hpp"
+#include "ShardedEngine.hpp"
+#include "LatencyHistogram.hpp"
+#include "OrderFlow.hpp"
+#include "DepthFeed.hpp"
+#include "OrderFeed.hpp"
+#include "ConflatingPublisher.hpp"
 #include "catch.hpp"
 #include <thread>
 #include <chrono>
 #include <iostream>
 #include <random>
 #include <vector>
+#include <csignal>
+#include <sys/resource.h>
 using namespace std;
 
-//func to calc median
-double computeMedian(vector<long long>& v)
-{
-    if(v.empty()) return 0.0;
-    sort(v.begin(), v.end());
-    size_t mid=v.size()/2;
-    if(v.size()%2==0) return (v[mid-1]+v[mid])/2.0;
-    return v[mid];
-}
-
-//func to calc 99th percentile
-double computePercentile(vector<long long>& v, double percentile)
-{
-    if(v.empty()) return 0.0;
-    sort(v.begin(), v.end());
-    size_t index=static_cast<size_t>(percentile/100.0*v.size());
-    if(index>=v.size()) index=v.size()-1;
-    return v[index];
-}
-
-TEST_CASE("Concurrent stress test on OrderBook", "[OrderBook][stress]")
+// run the stress test against both level layouts so they can be compared
+TEMPLATE_TEST_CASE("Concurrent stress test on OrderBook", "[OrderBook][stress]", OrderBook, LadderOrderBook)
 {
     auto start=chrono::high_resolution_clock::now();
 
-    OrderBook book;
+    TestType book;
     //start async order processing
     const int processorThreads = 8;
     vector<thread> processors;
     //launch half of the processors for buy orders and half for sell orders
     for(int i=0;i<processorThreads/2;i++)
-        processors.emplace_back(&OrderBook::processBuyOrders, &book);
+        processors.emplace_back(&TestType::processBuyOrders, &book);
     for(int i=0;i<processorThreads/2;i++)
-        processors.emplace_back(&OrderBook::processSellOrders, &book);
-    // store latencies from each thread
-    vector<long long> allLatencies;
-    mutex latenciesMutex;
+        processors.emplace_back(&TestType::processSellOrders, &book);
+    // addOrder latencies (ns) merged from each thread
+    LatencyHistogram allLatencies;
 
     //lambda to add random orders concurrently, mixes Limit, Market, IOC
-    auto addOrders=[&book, &latenciesMutex, &allLatencies](int startId, int orderCount)
+    auto addOrders=[&book, &allLatencies](int startId, int orderCount)
     {
         default_random_engine generator(random_device{}());
         uniform_real_distribution<double> priceDist(90.0, 110.0);
         uniform_int_distribution<int> qtyDist(1, 100);
         uniform_int_distribution<int> orderTypeDist(0, 2);//0=Limit, 1=Market, 2=IOC
-        // thread-local storage for latencies
-        vector<long long> localLatencies;
-        localLatencies.reserve(orderCount);
+        // thread-local histogram, merged once at the end
+        LatencyHistogram localLatencies;
         for(int i=0;i<orderCount;i++)
         {
             int orderId=startId+i;
@@ -78,14 +66,11 @@ TEST_CASE("Concurrent stress test on OrderBook", "[OrderBook][stress]")
             auto startTs=chrono::high_resolution_clock::now();
             book.addOrder(orderId, price, quantity, side, orderType);
             auto endTs=chrono::high_resolution_clock::now();   
-            auto diff=chrono::duration_cast<chrono::microseconds>(endTs-startTs).count();
-            localLatencies.push_back(diff);
+            auto diff=chrono::duration_cast<chrono::nanoseconds>(endTs-startTs).count();
+            localLatencies.record(diff);
         }   
-        // merge thread-local latencies into global vector
-        {
-            lock_guard<mutex> lk(latenciesMutex);
-            allLatencies.insert(allLatencies.end(), localLatencies.begin(), localLatencies.end());
-        } 
+        // merge is lock-free, so threads can fold in concurrently
+        allLatencies.merge(localLatencies);
     };    
     //launch several threads to add orders concurrently
     const int adderThreadCount=8;
@@ -98,11 +83,15 @@ TEST_CASE("Concurrent stress test on OrderBook", "[OrderBook][stress]")
     //allow time for the processing threads to work thru the orders
     this_thread::sleep_for(chrono::seconds(3));
 
+    //stop the processors and join them before checking, so a failed REQUIRE doesn't leave threads running
+    book.stopProcessing();
+    for(auto &t: processors) t.join();
+
     double bestBid = book.getBestBid();
     double bestAsk = book.getBestAsk();
     
-    // Either all orders matched so the book is empty…
-    if(bestBid == 0.0 && bestAsk == 0.0)    SUCCEED("Order book cleared out as expected");
+    // Either one side is empty (a best price of 0.0) so nothing can cross…
+    if(bestBid == 0.0 || bestAsk == 0.0)    SUCCEED("Order book cleared out as expected");
     else
     {
         // …or if not, then the best bid should be lower than the best ask.
@@ -110,27 +99,1185 @@ TEST_CASE("Concurrent stress test on OrderBook", "[OrderBook][stress]")
         INFO("Order book not cleared; verifying best bid < best ask");
         REQUIRE(bestBid < bestAsk);
     }
-    //stop the processors and join them
-    book.stopProcessing();
-    for(auto &t: processors) t.join();
     //end timer
     // Calculate stats for addOrder latencies
-    if(!allLatencies.empty())
-    {
-        // Compute average
-        long long sum = 0;
-        for(auto &val : allLatencies)
-            sum += val;
-        double avg = static_cast<double>(sum) / allLatencies.size();
-        
-        double med = computeMedian(allLatencies);
-        double p99 = computePercentile(allLatencies, 99.0);
-
-        cout << "[Latency] #Samples=" << allLatencies.size() 
-             << ", Avg=" << avg << " us"
-             << ", Median=" << med << " us"
-             << ", 99%=" << p99 << " us" 
-             << endl;
-    }
+    if(allLatencies.count()>0) allLatencies.print(cout, "Latency");
     else cout << "[Latency] No latencies recorded.\n";
-}
\ No newline at end of file
+}
+TEST_CASE("Prices are snapped to the book's tick size", "[OrderBook][price]")
+{
+    OrderBook book(PriceScale{0.01});
+    // both land on the 100.00 level, so cancelling one leaves the other as best bid
+    book.addOrder(1, 100.004, 10, "buy", OrderType::Limit);
+    book.addOrder(2, 99.996, 10, "buy", OrderType::Limit);
+    REQUIRE(book.getBestBid() == Approx(100.0));
+    REQUIRE(book.cancelOrder(1));
+    REQUIRE(book.getBestBid() == Approx(100.0));
+    REQUIRE(book.cancelOrder(2));
+    REQUIRE(book.getBestBid() == 0.0);
+}
+
+TEMPLATE_TEST_CASE("Cancel and modify unlink orders from any queue position", "[OrderBook][cancel]", OrderBook, LadderOrderBook)
+{
+    TestType book;
+    book.addOrder(1, 100, 10, "buy", OrderType::Limit);
+    book.addOrder(2, 100, 10, "buy", OrderType::Limit);
+    book.addOrder(3, 100, 10, "buy", OrderType::Limit);
+    book.addOrder(4, 101, 10, "buy", OrderType::Limit);
+    REQUIRE(book.cancelOrder(4));
+    REQUIRE_FALSE(book.cancelOrder(4));
+    REQUIRE(book.getBestBid() == Approx(100.0));
+    // middle of the level, then move the back of the level to a new best price
+    REQUIRE(book.cancelOrder(2));
+    REQUIRE(book.modifyOrder(3, 5, 102));
+    REQUIRE(book.getBestBid() == Approx(102.0));
+    REQUIRE(book.cancelOrder(3));
+    REQUIRE(book.getBestBid() == Approx(100.0));
+    REQUIRE(book.cancelOrder(1));
+    REQUIRE(book.getBestBid() == 0.0);
+}
+
+TEST_CASE("Order pool recycles slots and detects stale handles", "[OrderPool]")
+{
+    OrderPool pool(OrderPoolConfig{2, false});
+    Order *a = pool.acquire();
+    Order *b = pool.acquire();
+    REQUIRE(a != nullptr);
+    REQUIRE(b != nullptr);
+    REQUIRE(pool.acquire() == nullptr);
+
+    OrderHandle handle(a);
+    REQUIRE(handle.valid());
+    pool.release(a);
+    REQUIRE_FALSE(handle.valid());
+    REQUIRE(pool.acquire() == a);
+    REQUIRE_FALSE(handle.valid());
+    REQUIRE(pool.inUse() == 2);
+}
+
+TEST_CASE("Order index maps dense and sparse IDs to live slots", "[OrderIndex]")
+{
+    OrderPool pool(OrderPoolConfig{512, false});
+    OrderIndex index(OrderIndexConfig{1000, 16, 4});
+    // dense IDs, IDs past the dense limit and negative IDs, enough sparse ones to force rehashing and probe chains
+    vector<int> ids;
+    for(int i=0;i<100;i++) { ids.push_back(i*7); ids.push_back(1000+i*1024); ids.push_back(-1-i); }
+    map<int, Order*> expected;
+    for(int id : ids)
+    {
+        Order *o=pool.acquire();
+        REQUIRE(index.insert(id, o));
+        expected[id]=o;
+    }
+    REQUIRE_FALSE(index.insert(ids[1], pool.acquire())); // duplicate
+    REQUIRE(index.size()==ids.size());
+    for(auto &kv : expected) REQUIRE(index.find(kv.first)==kv.second);
+    REQUIRE(index.find(5)==nullptr);
+    REQUIRE(index.find(999999)==nullptr);
+
+    // erase every other ID; the rest must stay reachable through shifted probe runs
+    for(size_t i=0;i<ids.size();i+=2) { REQUIRE(index.erase(ids[i])); expected.erase(ids[i]); }
+    REQUIRE_FALSE(index.erase(ids[0]));
+    for(size_t i=0;i<ids.size();i++) REQUIRE(index.find(ids[i])==(i%2 ? expected[ids[i]] : nullptr));
+    size_t visited=0;
+    index.forEach([&](Order *) { visited++; });
+    REQUIRE(visited==expected.size());
+
+    // a recycled slot makes its old ID read as absent and free for reuse
+    Order *stale=expected[ids[1]];
+    pool.release(stale);
+    REQUIRE(index.find(ids[1])==nullptr);
+    REQUIRE(index.insert(ids[1], pool.acquire()));
+    index.clear();
+    REQUIRE(index.size()==0);
+    REQUIRE(index.find(ids[3])==nullptr);
+}
+
+TEST_CASE("Single-writer engine applies commands in submission order", "[MatchingEngine]")
+{
+    MatchingEngine engine;
+    engine.start();
+    Command add;
+    add.orderId=1; add.price=100; add.quantity=10; add.buy=true;
+    REQUIRE(engine.submit(add));
+    add.orderId=2; add.quantity=4; add.buy=false;   // crosses and partially fills order 1
+    REQUIRE(engine.submit(add));
+    Command cancel;
+    cancel.type=CommandType::Cancel; cancel.orderId=2; // already filled
+    REQUIRE(engine.submit(cancel));
+    Command modify;
+    modify.type=CommandType::Modify; modify.orderId=1; modify.quantity=6; modify.price=101;
+    REQUIRE(engine.submit(modify));
+    engine.stop();
+
+    vector<CommandResult> results;
+    CommandResult result;
+    while(engine.pollResult(result)) results.push_back(result);
+    REQUIRE(results.size()==4);
+    for(size_t i=0;i<results.size();i++) REQUIRE(results[i].sequence==i+1);
+    REQUIRE(results[0].accepted);
+    REQUIRE(results[1].accepted);
+    REQUIRE_FALSE(results[2].accepted);
+    REQUIRE(results[3].accepted);
+    REQUIRE(engine.book().getBestBid()==Approx(101.0));
+    REQUIRE(engine.book().getBestAsk()==0.0);
+}
+
+TEST_CASE("Engine journal rebuilds the book on restart", "[MatchingEngine][journal]")
+{
+    string path="/tmp/orderbook_journal_test_"+to_string(getpid())+".bin";
+    unlink(path.c_str());
+    MatchingEngineConfig config;
+    config.journalPath=path;
+    config.groupCommit=3;
+    config.waitMode=WaitMode::Blocking;
+
+    auto add=[](int id, bool buy, double price, int qty, OrderType type=OrderType::Limit) {
+        Command c; c.orderId=id; c.buy=buy; c.price=price; c.quantity=qty; c.orderType=type; return c;
+    };
+    TopOfBookSnapshot before;
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        REQUIRE(engine.recovered()==0);
+        engine.submit(add(1, true, 100, 10));
+        engine.submit(add(2, false, 101, 5));
+        engine.submit(add(3, false, 100, 4));               // partially fills order 1
+        Command modify; modify.type=CommandType::Modify; modify.orderId=2; modify.quantity=7; modify.price=102;
+        engine.submit(modify);
+        engine.submit(add(4, true, 105, 1, OrderType::Stop));
+        Command cancel; cancel.type=CommandType::Cancel; cancel.orderId=99;  // rejected, journaled all the same
+        engine.submit(cancel);
+        engine.submit(add(5, true, 99, 3));
+        cancel.orderId=5;
+        engine.submit(cancel);
+        engine.stop();
+        size_t results=0;
+        CommandResult result;
+        while(engine.pollResult(result)) results++;
+        REQUIRE(results==8);
+        REQUIRE(engine.journalErrors()==0);
+        before=engine.book().topOfBook();
+    }
+    // a crash mid-append leaves a torn record behind
+    {
+        int fd=open(path.c_str(), O_WRONLY | O_APPEND);
+        REQUIRE(write(fd, "torn", 4)==4);
+        close(fd);
+    }
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        engine.submit(add(1, true, 100, 1));                 // still resting after replay: duplicate
+        engine.stop();
+        REQUIRE(engine.recovered()==8);
+        REQUIRE(engine.processed()==9);
+        CommandResult result;
+        REQUIRE(engine.pollResult(result));
+        REQUIRE_FALSE(result.accepted);
+        REQUIRE(result.sequence==9);
+        TopOfBookSnapshot after=engine.book().topOfBook();
+        REQUIRE(after.top==before.top);
+        REQUIRE(after.top.bidQuantity==6);
+        REQUIRE(after.top.askPrice==engine.book().priceScale().toTicks(102));
+        REQUIRE(engine.book().pendingStopOrders()==1);
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("A rejected last command keeps its sequence number across a restart", "[MatchingEngine][journal]")
+{
+    string path="/tmp/orderbook_journal_rejected_"+to_string(getpid())+".bin";
+    unlink(path.c_str());
+    MatchingEngineConfig config;
+    config.journalPath=path;
+    config.waitMode=WaitMode::Blocking;
+    Command add; add.orderId=1; add.buy=true; add.price=100; add.quantity=10;
+    Command cancel; cancel.type=CommandType::Cancel; cancel.orderId=42;
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        engine.submit(add);
+        engine.submit(cancel);
+        engine.stop();
+        CommandResult result;
+        REQUIRE(engine.pollResult(result));
+        REQUIRE((result.accepted && result.sequence==1));
+        REQUIRE(engine.pollResult(result));
+        REQUIRE((!result.accepted && result.sequence==2));
+    }
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        add.orderId=2;
+        engine.submit(add);
+        engine.stop();
+        REQUIRE(engine.recovered()==2);
+        CommandResult result;
+        REQUIRE(engine.pollResult(result));
+        REQUIRE(result.accepted);
+        REQUIRE(result.sequence==3);
+        REQUIRE(engine.book().topOfBook().top.bidQuantity==20);
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("A failed journal commit withholds results and stops the engine", "[MatchingEngine][journal]")
+{
+    string path="/tmp/orderbook_journal_failed_"+to_string(getpid())+".bin";
+    unlink(path.c_str());
+    MatchingEngineConfig config;
+    config.journalPath=path;
+    config.groupCommit=1;
+    config.waitMode=WaitMode::Blocking;
+
+    // cap the file size at the journal header so the first group's write fails with EFBIG
+    struct rlimit saved;
+    REQUIRE(getrlimit(RLIMIT_FSIZE, &saved)==0);
+    auto savedHandler=signal(SIGXFSZ, SIG_IGN);
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        struct rlimit capped=saved;
+        capped.rlim_cur=sizeof(JournalHeader);
+        REQUIRE(setrlimit(RLIMIT_FSIZE, &capped)==0);
+        Command add; add.orderId=1; add.buy=true; add.price=100; add.quantity=10;
+        REQUIRE(engine.submit(add));
+        for(int i=0;i<2000 && !engine.failed();i++) this_thread::sleep_for(chrono::milliseconds(1));
+        REQUIRE(engine.failed());
+        REQUIRE(engine.journalErrors()==1);
+        REQUIRE_FALSE(engine.submit(add));
+        engine.stop();
+        CommandResult result;
+        REQUIRE_FALSE(engine.pollResult(result));
+    }
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, savedHandler);
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        engine.stop();
+        REQUIRE(engine.recovered()==0);
+        REQUIRE(engine.book().topOfBook().top.bidQuantity==0);
+    }
+    unlink(path.c_str());
+}
+
+TEST_CASE("Engine restarts from a snapshot plus the journal tail", "[MatchingEngine][snapshot]")
+{
+    string base="/tmp/orderbook_snapshot_test_"+to_string(getpid());
+    MatchingEngineConfig config;
+    config.journalPath=base+".journal";
+    config.snapshotPath=base+".snapshot";
+    config.snapshotInterval=5;
+    config.groupCommit=2;
+    config.waitMode=WaitMode::Blocking;
+    unlink(config.journalPath.c_str());
+    unlink(config.snapshotPath.c_str());
+
+    auto sameEntries=[](const BookSnapshot &a, const BookSnapshot &b) {
+        if(a.entries.size()!=b.entries.size() || a.header.orderCount!=b.header.orderCount) return false;
+        for(size_t i=0;i<a.entries.size();i++)
+            if(memcmp(&a.entries[i], &b.entries[i], sizeof(SnapshotEntry))!=0) return false;
+        return true;
+    };
+    BookSnapshot before;
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        Command c;
+        for(int i=1;i<=12;i++)
+        {
+            // resting orders on both sides, crossing orders that partially fill, and a stop of each kind
+            c.orderId=i; c.buy=i%2; c.quantity=10+i; c.orderType=OrderType::Limit;
+            c.price=c.buy ? 99+(i%4==1) : 101-(i%4==0);
+            if(i%4==3) { c.price=c.buy ? 101 : 99; c.quantity=3; }
+            if(i==6 || i==7) { c.orderType=OrderType::Stop; c.price=i==6 ? 90 : 110; }
+            engine.submit(c);
+        }
+        Command cancel; cancel.type=CommandType::Cancel; cancel.orderId=2;
+        engine.submit(cancel);
+        engine.stop();
+        CommandResult result;
+        while(engine.pollResult(result)) {}
+        REQUIRE(engine.snapshotsWritten()>=1);
+        engine.book().captureSnapshot(before);
+        REQUIRE(before.header.orderCount>=2);
+        REQUIRE(before.header.stopCount==2);
+    }
+    {
+        MatchingEngine engine(config);
+        REQUIRE(engine.start());
+        engine.stop();
+        REQUIRE(engine.snapshotSequence()>=5);
+        REQUIRE(engine.recovered()<13);
+        REQUIRE(engine.processed()==13);
+        BookSnapshot after;
+        engine.book().captureSnapshot(after);
+        REQUIRE(sameEntries(before, after));
+        REQUIRE(after.header.lastTradePrice==before.header.lastTradePrice);
+    }
+
+    // a book with a different tick size refuses the state
+    MappedSnapshot mapped;
+    REQUIRE(mapped.open(config.snapshotPath));
+    OrderBook coarse(PriceScale{0.05});
+    REQUIRE_FALSE(coarse.restoreSnapshot(mapped.header(), mapped.entries()));
+    OrderBook book;
+    REQUIRE(book.restoreSnapshot(mapped.header(), mapped.entries()));
+    BookSnapshot restored;
+    book.captureSnapshot(restored);
+    REQUIRE(restored.header.orderCount==mapped.header().orderCount);
+    REQUIRE(restored.header.stopCount==mapped.header().stopCount);
+    unlink(config.journalPath.c_str());
+    unlink(config.snapshotPath.c_str());
+}
+
+TEST_CASE("Sharded engine routes each symbol to its own book", "[ShardedEngine]")
+{
+    ShardedEngineConfig config;
+    config.symbolCount=10;
+    config.shardCount=3;
+    config.waitMode=WaitMode::Blocking;
+    ShardedEngine engine(config);
+    REQUIRE(engine.shardOf(7)==1);
+    engine.start();
+    Command add;
+    add.quantity=10;
+    for(uint32_t s=0;s<10;s++)
+    {
+        // the same order IDs on every symbol: books are independent
+        add.symbol=s; add.orderId=1; add.buy=true; add.price=100+s;
+        REQUIRE(engine.submit(add));
+        add.orderId=2; add.buy=false; add.quantity=4;   // partially fills order 1
+        REQUIRE(engine.submit(add));
+        add.quantity=10;
+    }
+    add.symbol=10;
+    REQUIRE_FALSE(engine.submit(add));
+    engine.stop();
+
+    REQUIRE(engine.processed()==20);
+    vector<uint64_t> lastSequence(3, 0);
+    size_t results=0;
+    CommandResult result;
+    while(engine.pollResult(result))
+    {
+        results++;
+        REQUIRE(result.accepted);
+        uint64_t &last=lastSequence[engine.shardOf(result.symbol)];
+        REQUIRE(result.sequence==last+1);
+        last=result.sequence;
+    }
+    REQUIRE(results==20);
+    for(uint32_t s=0;s<10;s++)
+    {
+        TopOfBookSnapshot snap=engine.book(s).topOfBook();
+        REQUIRE(engine.book(s).getBestBid()==Approx(100+s));
+        REQUIRE(snap.top.bidQuantity==6);
+        REQUIRE(snap.top.askQuantity==0);
+    }
+}
+
+TEST_CASE("Sharded engine applies every command submitted before stop", "[ShardedEngine]")
+{
+    for(WaitMode mode : {WaitMode::BusySpin, WaitMode::Blocking})
+    {
+        for(int round=0;round<50;round++)
+        {
+            ShardedEngineConfig config;
+            config.symbolCount=8;
+            config.shardCount=4;
+            config.waitMode=mode;
+            ShardedEngine engine(config);
+            engine.start();
+            Command add; add.buy=true; add.price=100; add.quantity=1;
+            for(uint32_t s=0;s<config.symbolCount;s++)
+            {
+                add.symbol=s; add.orderId=round+1;
+                REQUIRE(engine.submit(add));
+            }
+            engine.stop();
+            REQUIRE(engine.processed()==config.symbolCount);
+            size_t results=0;
+            CommandResult result;
+            while(engine.pollResult(result)) results++;
+            REQUIRE(results==config.symbolCount);
+            REQUIRE(engine.droppedResults()==0);
+        }
+    }
+
+    // results that do not fit an undrained outbound ring are counted, not lost silently
+    ShardedEngineConfig config;
+    config.symbolCount=2;
+    config.shardCount=2;
+    config.outboundCapacity=4;
+    ShardedEngine engine(config);
+    engine.start();
+    Command add; add.buy=true; add.price=100; add.quantity=1;
+    for(int i=1;i<=20;i++)
+    {
+        for(uint32_t s=0;s<2;s++) { add.symbol=s; add.orderId=i; REQUIRE(engine.submit(add)); }
+    }
+    engine.stop();
+    REQUIRE(engine.processed()==40);
+    size_t results=0;
+    CommandResult result;
+    while(engine.pollResult(result)) results++;
+    REQUIRE(results==8);
+    REQUIRE(results+engine.droppedResults()==40);
+}
+
+TEST_CASE("Processor threads wake promptly under every wait strategy", "[OrderBook][wait]")
+{
+    auto mode=GENERATE(WaitMode::BusySpin, WaitMode::SpinThenYield, WaitMode::Blocking);
+    OrderBook book(PriceScale{}, MapPriceLevels::Config{}, OrderPoolConfig{}, mode);
+    thread buyer(&OrderBook::processBuyOrders, &book);
+    thread seller(&OrderBook::processSellOrders, &book);
+    // let the consumers go idle before the crossing orders arrive
+    this_thread::sleep_for(chrono::milliseconds(20));
+    book.addOrder(1, 100, 10, "buy", OrderType::Limit);
+    book.addOrder(2, 100, 10, "sell", OrderType::Limit);
+    auto deadline=chrono::steady_clock::now()+chrono::seconds(2);
+    while(book.getBestBid()!=0.0 && chrono::steady_clock::now()<deadline)
+        this_thread::yield();
+    book.stopProcessing();
+    buyer.join();
+    seller.join();
+    REQUIRE(book.getBestBid()==0.0);
+    REQUIRE(book.getBestAsk()==0.0);
+}
+
+TEST_CASE("Book publishes structured execution events", "[OrderBook][events]")
+{
+    EventRing events(64);
+    OrderBook book;
+    book.setEventRing(&events);
+    book.addOrder(1, 100, 10, "sell", OrderType::Limit);
+    book.addOrder(2, 101, 4, "buy", OrderType::IOC);    // fills 4 at 100
+    book.addOrder(3, 99, 20, "buy", OrderType::Market); // fills the remaining 6, 14 expire
+    book.addOrder(4, 100, 5, "sell", OrderType::Limit);
+    book.addOrder(4, 100, 5, "sell", OrderType::Limit); // duplicate
+    REQUIRE(book.modifyOrder(4, 3, 102));
+    REQUIRE(book.cancelOrder(4));
+
+    vector<BookEvent> seen;
+    BookEvent event;
+    while(events.poll(event)) seen.push_back(event);
+    vector<EventType> expected{EventType::Accept, EventType::Accept, EventType::Fill,
+                               EventType::Accept, EventType::Fill, EventType::Expired,
+                               EventType::Accept, EventType::Reject, EventType::ModifyAck,
+                               EventType::CancelAck};
+    REQUIRE(seen.size()==expected.size());
+    for(size_t i=0;i<seen.size();i++)
+    {
+        REQUIRE(seen[i].type==expected[i]);
+        REQUIRE(seen[i].sequence==i+1);
+    }
+    REQUIRE(seen[2].orderId==2);
+    REQUIRE(seen[2].contraOrderId==1);
+    REQUIRE(seen[2].quantity==4);
+    REQUIRE(seen[2].price==book.priceScale().toTicks(100));
+    REQUIRE(seen[5].quantity==14);
+    REQUIRE(seen[7].reason==RejectReason::DuplicateId);
+    REQUIRE(events.dropped()==0);
+}
+
+// statically bound listener that records what the book reports
+struct RecordingListener
+{
+    vector<BookEvent> fills;
+    vector<BookEvent> updates;
+    vector<TopOfBook> tops;
+    void onFill(const BookEvent &e) { fills.push_back(e); }
+    void onOrderUpdate(const BookEvent &e) { updates.push_back(e); }
+    void onTopOfBook(const TopOfBook &t) { tops.push_back(t); }
+};
+
+TEST_CASE("Listener receives fills and top-of-book changes", "[OrderBook][listener]")
+{
+    BasicOrderBook<MapPriceLevels, mutex, RecordingListener> book;
+    const PriceScale &scale=book.priceScale();
+    book.addOrder(1, 100, 10, "sell", OrderType::Limit);
+    book.addOrder(2, 100, 5, "sell", OrderType::Limit);
+    book.addOrder(3, 101, 12, "buy", OrderType::IOC);
+
+    RecordingListener &l=book.listener();
+    REQUIRE(l.fills.size()==2);
+    REQUIRE(l.fills[0].contraOrderId==1);
+    REQUIRE(l.fills[0].quantity==10);
+    REQUIRE(l.fills[1].contraOrderId==2);
+    REQUIRE(l.fills[1].quantity==2);
+    REQUIRE(l.updates.size()==3); // two accepts for the resting orders, one for the IOC
+    REQUIRE(l.tops.size()==3);
+    REQUIRE(l.tops[0].askPrice==scale.toTicks(100));
+    REQUIRE(l.tops[0].askQuantity==10);
+    REQUIRE(l.tops[1].askQuantity==15);
+    REQUIRE(l.tops[2].askQuantity==3);
+    REQUIRE(l.tops[2].bidQuantity==0);
+}
+
+TEST_CASE("Dynamic listener forwards through a BookListener", "[OrderBook][listener]")
+{
+    struct CountingListener : BookListener
+    {
+        int fills=0;
+        void onFill(const BookEvent &) override { fills++; }
+    } counter;
+    BasicOrderBook<MapPriceLevels, mutex, DynamicBookListener> book;
+    book.listener().target=&counter;
+    book.addOrder(1, 100, 10, "buy", OrderType::Limit);
+    book.addOrder(2, 100, 10, "sell", OrderType::Market);
+    REQUIRE(counter.fills==1);
+}
+
+TEST_CASE("Latency histogram percentiles stay within bucket precision", "[LatencyHistogram]")
+{
+    LatencyHistogram a, b;
+    for(uint64_t v=1;v<=100000;v++) (v%2 ? a : b).record(v);
+    a.merge(b);
+    REQUIRE(a.count()==100000);
+    REQUIRE(a.min()==1);
+    REQUIRE(a.max()==100000);
+    REQUIRE(a.mean()==Approx(50000.5));
+    // values below 256 are exact, above that within 1%
+    REQUIRE(a.percentile(0.1)==100);
+    REQUIRE(a.percentile(50)==Approx(50000).epsilon(0.01));
+    REQUIRE(a.percentile(99)==Approx(99000).epsilon(0.01));
+    REQUIRE(a.percentile(99.99)==Approx(99990).epsilon(0.01));
+    REQUIRE(a.percentile(100)==100000);
+}
+
+TEST_CASE("Stop orders trigger from the touch and the last trade", "[OrderBook][stop]")
+{
+    BasicOrderBook<MapPriceLevels, NullMutex, RecordingListener> book;
+    book.addOrder(1, 100, 5, "sell", OrderType::Limit);
+    book.addOrder(2, 102, 20, "sell", OrderType::Limit);
+    book.addOrder(3, 97, 20, "buy", OrderType::Limit);
+    REQUIRE(book.addStopOrder(10, 101, 3, "buy"));
+    REQUIRE(book.addOrder(11, 103, 1, "buy", OrderType::Stop));
+    REQUIRE(book.addStopOrder(20, 96, 1, "sell"));
+    REQUIRE_FALSE(book.addStopOrder(3, 90, 1, "sell")); // ID of a resting order
+    REQUIRE(book.pendingStopOrders()==3);
+    REQUIRE(book.cancelOrder(11));
+    REQUIRE(book.pendingStopOrders()==2);
+
+    // lifting the 100 offer moves the ask to 102, crossing stop 10
+    book.addOrder(4, 0, 5, "buy", OrderType::Market);
+    REQUIRE(book.pendingStopOrders()==1);
+    RecordingListener &l=book.listener();
+    REQUIRE(l.fills.size()==2);
+    REQUIRE(l.fills[1].orderId==10);
+    REQUIRE(l.fills[1].contraOrderId==2);
+    REQUIRE(l.fills[1].quantity==3);
+
+    // last trade at 97 is above stop 20, but a new stop at 98 is already crossed
+    book.addOrder(5, 0, 20, "sell", OrderType::Market);
+    REQUIRE(book.pendingStopOrders()==1);
+    REQUIRE(book.addStopOrder(21, 98, 1, "sell"));
+    REQUIRE(book.pendingStopOrders()==1);
+    int triggered=0;
+    for(const BookEvent &e : l.updates)
+        if(e.type==EventType::Triggered) { triggered++; REQUIRE((e.orderId==10 || e.orderId==21)); }
+    REQUIRE(triggered==2);
+    REQUIRE(book.cancelOrder(20));
+    REQUIRE(book.pendingStopOrders()==0);
+}
+
+TEST_CASE("Stop fills cascade into further stops in trigger-price order", "[OrderBook][stop]")
+{
+    BasicOrderBook<MapPriceLevels, NullMutex, RecordingListener> book;
+    const PriceScale &scale=book.priceScale();
+    RecordingListener &l=book.listener();
+    for(int i=0;i<4;i++) book.addOrder(1+i, 100+i, 1, "sell", OrderType::Limit);
+    book.addOrder(5, 105, 5, "sell", OrderType::Limit);
+    book.addStopOrder(10, 101, 1, "buy");
+    book.addStopOrder(11, 102, 1, "buy");
+    book.addStopOrder(12, 102, 1, "buy");   // same trigger, behind 11
+    book.addStopOrder(13, 110, 1, "buy");   // never reached
+
+    // each stop's fill lifts the ask into the next trigger
+    book.addOrder(6, 0, 1, "buy", OrderType::Market);
+    REQUIRE(l.fills.size()==4);
+    int buyers[]={6, 10, 11, 12};
+    for(int i=0;i<4;i++)
+    {
+        REQUIRE(l.fills[i].orderId==buyers[i]);
+        REQUIRE(l.fills[i].contraOrderId==1+i);
+        REQUIRE(l.fills[i].price==scale.toTicks(100+i));
+    }
+    REQUIRE(book.pendingStopOrders()==1);
+    REQUIRE(book.getBestAsk()==Approx(105.0));
+
+    // both sell stops are crossed in the same round: the higher trigger goes
+    // first even though it arrived later
+    l.fills.clear();
+    for(int i=0;i<3;i++) book.addOrder(7+i, 95-i, 1, "buy", OrderType::Limit);
+    book.addStopOrder(20, 93, 1, "sell");
+    book.addStopOrder(21, 94, 1, "sell");
+    book.addOrder(30, 0, 2, "sell", OrderType::Market);
+    REQUIRE(l.fills.size()==3);
+    REQUIRE(l.fills[2].orderId==21);
+    REQUIRE(l.fills[2].price==scale.toTicks(93));
+    REQUIRE(l.updates.back().type==EventType::Expired);
+    REQUIRE(l.updates.back().orderId==20);
+    REQUIRE(book.pendingStopOrders()==1);
+}
+
+TEST_CASE("Top-of-book snapshot is readable without the book lock", "[OrderBook][seqlock]")
+{
+    // the writer keeps every field equal, so a torn read would show up as a mismatch
+    struct Quad { uint64_t a, b, c, d; };
+    Seqlock<Quad> lock;
+    atomic<bool> done{false};
+    atomic<int> torn{0};
+    thread reader([&] {
+        uint64_t last=0;
+        while(!done)
+        {
+            Quad q=lock.read();
+            if(q.a!=q.b || q.b!=q.c || q.c!=q.d || q.a<last) torn++;
+            last=q.a;
+        }
+    });
+    for(uint64_t i=1;i<=200000;i++) lock.write(Quad{i, i, i, i});
+    done=true;
+    reader.join();
+    REQUIRE(torn==0);
+    REQUIRE(lock.read().d==200000);
+
+    OrderBook book;
+    REQUIRE(book.topOfBook().sequence==0);
+    book.addOrder(1, 99.5, 10, "buy", OrderType::Limit);
+    book.addOrder(2, 100.5, 7, "sell", OrderType::Limit);
+    book.addOrder(3, 99.5, 5, "buy", OrderType::Limit);
+    book.addOrder(4, 80, 5, "buy", OrderType::Limit);    // behind the touch: no new snapshot
+    TopOfBookSnapshot snap=book.topOfBook();
+    REQUIRE(snap.sequence==3);
+    REQUIRE(snap.top.bidPrice==book.priceScale().toTicks(99.5));
+    REQUIRE(snap.top.bidQuantity==15);
+    REQUIRE(snap.top.askQuantity==7);
+    REQUIRE(book.getBestBid()==Approx(99.5));
+    REQUIRE(book.getBestAsk()==Approx(100.5));
+
+    // an order modified down to 0 still rests, so its side is not empty
+    OrderBook zero;
+    zero.addOrder(1, 99.5, 10, "buy", OrderType::Limit);
+    REQUIRE(zero.modifyOrder(1, 0, 99.5));
+    snap=zero.topOfBook();
+    REQUIRE(snap.top.hasBid);
+    REQUIRE(snap.top.bidQuantity==0);
+    REQUIRE_FALSE(snap.top.hasAsk);
+    REQUIRE(zero.getBestBid()==Approx(99.5));
+    REQUIRE(zero.getBestAsk()==0.0);
+    REQUIRE(zero.cancelOrder(1));
+    REQUIRE_FALSE(zero.topOfBook().top.hasBid);
+    REQUIRE(zero.getBestBid()==0.0);
+}
+
+TEST_CASE("Order flow replays from a mapped file with a stable checksum", "[replay]")
+{
+    string path="/tmp/orderbook_flow_test_"+to_string(getpid());
+    auto event=[](uint64_t t, CommandType type, OrderType orderType, int id, double price, int qty, Side side) {
+        FlowEvent e;
+        e.timestamp=t; e.type=type; e.orderType=orderType; e.orderId=id; e.price=price; e.quantity=qty; e.side=side;
+        return e;
+    };
+    vector<FlowEvent> events={
+        event(0, CommandType::Add, OrderType::Limit, 1, 99.0, 10, Side::Buy),
+        event(1000, CommandType::Add, OrderType::Limit, 2, 101.0, 10, Side::Sell),
+        event(2000, CommandType::Add, OrderType::Stop, 3, 101.0, 4, Side::Buy),
+        event(3000, CommandType::Add, OrderType::Limit, 4, 98.0, 6, Side::Buy),
+        event(4000, CommandType::Modify, OrderType::Limit, 4, 99.0, 8, Side::Buy),
+        event(5000, CommandType::Add, OrderType::Market, 5, 0.0, 3, Side::Buy),    // trades at 101, elects the stop
+        event(6000, CommandType::Add, OrderType::IOC, 6, 99.0, 12, Side::Sell),
+        event(7000, CommandType::Cancel, OrderType::Limit, 2, 0.0, 0, Side::Sell),
+        event(8000, CommandType::Cancel, OrderType::Limit, 42, 0.0, 0, Side::Sell), // unknown id: rejected
+    };
+    REQUIRE(writeOrderFlow(path, events));
+
+    MappedOrderFlow flow;
+    REQUIRE(flow.open(path));
+    REQUIRE(flow.size()==events.size());
+
+    OrderBook fast;
+    ReplayReport fastReport;
+    replayOrderFlow(fast, flow.events(), flow.size(), ReplayOptions{}, fastReport);
+    REQUIRE(fastReport.events==events.size());
+    REQUIRE(fastReport.accepted==events.size()-1);
+    REQUIRE(fastReport.latency.count()==events.size());
+    REQUIRE(fast.pendingStopOrders()==0);
+    REQUIRE(fast.getBestBid()==Approx(99.0));
+    REQUIRE(fast.getBestAsk()==0.0);
+
+    // paced at the recorded timestamps: same book, and it takes at least the recorded span
+    OrderBook paced;
+    ReplayOptions options;
+    options.paced=true;
+    ReplayReport pacedReport;
+    replayOrderFlow(paced, flow.events(), flow.size(), options, pacedReport);
+    REQUIRE(pacedReport.checksum==fastReport.checksum);
+    REQUIRE(pacedReport.seconds>=8e-6);
+
+    // the checksum follows the book state
+    OrderBook direct;
+    for(const FlowEvent &e : events) applyCommand(direct, e.command());
+    REQUIRE(bookChecksum(direct)==fastReport.checksum);
+    REQUIRE(direct.cancelOrder(4));
+    REQUIRE(bookChecksum(direct)!=fastReport.checksum);
+
+    flow.close();
+    unlink(path.c_str());
+    REQUIRE_FALSE(flow.open(path));
+}
+
+TEST_CASE("Depth increments rebuild the book's levels", "[depth]")
+{
+    using Book=BasicOrderBook<MapPriceLevels, NullMutex>;
+    Book book;
+    DepthRing ring(1<<16);
+    book.setDepthRing(&ring);
+    auto sameLevels=[](const vector<DepthLevel> &a, const vector<DepthLevel> &b) {
+        if(a.size()!=b.size()) return false;
+        for(size_t i=0;i<a.size();i++)
+            if(a[i].price!=b[i].price || a[i].quantity!=b[i].quantity || a[i].orderCount!=b[i].orderCount) return false;
+        return true;
+    };
+
+    DepthBook fromStart;
+    DepthBook lateJoiner;
+    bool joined=false;
+    mt19937 rng(7);
+    DepthUpdate update;
+    vector<int> live;
+    for(int i=1;i<=20000;i++)
+    {
+        int roll=rng()%100;
+        Side side=rng()%2 ? Side::Buy : Side::Sell;
+        if(roll<25 && !live.empty())
+        {
+            size_t pick=rng()%live.size();
+            if(roll<15) book.cancelOrder(live[pick]);
+            else book.modifyOrder(live[pick], 1+rng()%50, 100.0+(int(rng()%21)-10)*0.01);
+        }
+        else if(roll<32) book.addOrder(i, 0.0, 1+rng()%120, side, OrderType::Market);
+        else if(roll<35) book.addOrder(i, 100.0+(side==Side::Buy ? 0.2 : -0.2), 10, side, OrderType::Stop);
+        else
+        {
+            book.addOrder(i, 100.0+(side==Side::Buy ? -1 : 1)*int(rng()%10)*0.01, 1+rng()%50, side, OrderType::Limit);
+            live.push_back(i);
+        }
+        if(i==10000) book.reset();
+        if(i==5000)
+        {
+            // a consumer that starts mid-stream: snapshot now, skip what the snapshot already covers
+            DepthSnapshot snapshot;
+            book.captureDepth(1000, snapshot);
+            lateJoiner.load(snapshot);
+            joined=true;
+        }
+        while(ring.poll(update))
+        {
+            REQUIRE(fromStart.apply(update));
+            if(joined) REQUIRE(lateJoiner.apply(update));
+        }
+        if(i%500==0)
+        {
+            DepthSnapshot expected;
+            book.captureDepth(1000, expected);
+            DepthSnapshot rebuilt=fromStart.top(1000);
+            REQUIRE(rebuilt.sequence==expected.sequence);
+            REQUIRE(sameLevels(rebuilt.bids, expected.bids));
+            REQUIRE(sameLevels(rebuilt.asks, expected.asks));
+            if(joined)
+            {
+                REQUIRE(sameLevels(lateJoiner.top(1000).bids, expected.bids));
+                REQUIRE(sameLevels(lateJoiner.top(1000).asks, expected.asks));
+            }
+        }
+    }
+    REQUIRE(ring.dropped()==0);
+
+    // one update per level a mutation touched: a sweep of two levels deletes both
+    book.reset();
+    while(ring.poll(update)) {}
+    book.addOrder(1, 101.0, 5, Side::Sell, OrderType::Limit);
+    book.addOrder(2, 102.0, 5, Side::Sell, OrderType::Limit);
+    book.addOrder(3, 102.0, 5, Side::Sell, OrderType::Limit);
+    vector<DepthUpdate> updates;
+    while(ring.poll(update)) updates.push_back(update);
+    REQUIRE(updates.size()==3);
+    REQUIRE(updates[0].action==DepthAction::Add);
+    REQUIRE(updates[2].action==DepthAction::Change);
+    REQUIRE(updates[2].orderCount==2);
+    REQUIRE(updates[2].quantity==10);
+    book.addOrder(4, 0.0, 12, Side::Buy, OrderType::Market);
+    updates.clear();
+    while(ring.poll(update)) updates.push_back(update);
+    REQUIRE(updates.size()==2);
+    REQUIRE(updates[0].action==DepthAction::Delete);
+    REQUIRE(updates[0].price==book.priceScale().toTicks(101.0));
+    REQUIRE(updates[1].action==DepthAction::Change);
+    REQUIRE(updates[1].quantity==3);
+    REQUIRE(updates[1].orderCount==1);
+    // a limit that fully fills on arrival never shows on its own side
+    book.addOrder(5, 102.0, 3, Side::Buy, OrderType::Limit);
+    updates.clear();
+    while(ring.poll(update)) updates.push_back(update);
+    REQUIRE(updates.size()==1);
+    REQUIRE(updates[0].side==Side::Sell);
+    REQUIRE(updates[0].action==DepthAction::Delete);
+}
+
+TEST_CASE("Order feed rebuilds every resting queue", "[feed]")
+{
+    using Book=BasicOrderBook<MapPriceLevels, NullMutex>;
+    Book book;
+    OrderFeedRing ring(1<<16);
+    book.setOrderFeed(&ring);
+
+    // consumer side: per-order state plus each level's queue, rebuilt from the messages
+    struct Resting { Price price; int quantity; Side side; };
+    unordered_map<int, Resting> orders;
+    map<pair<int, Price>, list<int>> queues;
+    uint64_t expected=1;
+    auto unlink=[&](int id) {
+        Resting &r=orders.at(id);
+        auto &queue=queues[{int(r.side), r.price}];
+        queue.remove(id);
+        if(queue.empty()) queues.erase({int(r.side), r.price});
+        orders.erase(id);
+    };
+    auto drain=[&]() {
+        OrderMessage m;
+        while(ring.poll(m))
+        {
+            REQUIRE(m.sequence==expected++);
+            switch(m.type)
+            {
+                case OrderFeedType::Add:
+                    REQUIRE(orders.count(m.orderId)==0);
+                    orders[m.orderId]=Resting{m.price, m.quantity, m.side};
+                    queues[{int(m.side), m.price}].push_back(m.orderId);
+                    break;
+                case OrderFeedType::Replace:
+                    unlink(m.orderId);
+                    orders[m.orderId]=Resting{m.price, m.quantity, m.side};
+                    queues[{int(m.side), m.price}].push_back(m.orderId);
+                    break;
+                case OrderFeedType::Execute:
+                    REQUIRE(orders.count(m.orderId)==1);
+                    REQUIRE(orders[m.orderId].quantity>=m.quantity);
+                    REQUIRE(orders[m.orderId].price==m.price);
+                    if((orders[m.orderId].quantity-=m.quantity)==0) unlink(m.orderId);
+                    break;
+                case OrderFeedType::Delete:
+                    unlink(m.orderId);
+                    break;
+                case OrderFeedType::Clear:
+                    orders.clear();
+                    queues.clear();
+                    break;
+            }
+        }
+    };
+    auto matchesBook=[&]() {
+        BookSnapshot snap;
+        book.captureSnapshot(snap);
+        if(snap.header.orderCount!=orders.size()) return false;
+        for(uint64_t i=0;i<snap.header.orderCount;i++)
+        {
+            const SnapshotEntry &e=snap.entries[i];
+            auto &queue=queues[{int(e.side), e.price}];
+            if(queue.empty() || queue.front()!=e.orderId || orders[e.orderId].quantity!=e.quantity) return false;
+            queue.pop_front();   // consumed for the comparison; rebuilt below
+        }
+        orders.clear();
+        queues.clear();
+        for(uint64_t i=0;i<snap.header.orderCount;i++)
+        {
+            const SnapshotEntry &e=snap.entries[i];
+            orders[e.orderId]=Resting{e.price, e.quantity, e.side};
+            queues[{int(e.side), e.price}].push_back(e.orderId);
+        }
+        return true;
+    };
+
+    mt19937 rng(11);
+    vector<int> live;
+    for(int i=1;i<=20000;i++)
+    {
+        int roll=rng()%100;
+        Side side=rng()%2 ? Side::Buy : Side::Sell;
+        if(roll<25 && !live.empty())
+        {
+            size_t pick=rng()%live.size();
+            if(roll<15) book.cancelOrder(live[pick]);
+            else book.modifyOrder(live[pick], 1+rng()%50, 100.0+(int(rng()%21)-10)*0.01);
+        }
+        else if(roll<30) book.addOrder(i, 0.0, 1+rng()%120, side, OrderType::Market);
+        else if(roll<33) book.addOrder(i, 100.0+(side==Side::Buy ? 0.03 : -0.03), 1+rng()%60, side, OrderType::IOC);
+        else if(roll<35) book.addOrder(i, 100.0+(side==Side::Buy ? 0.2 : -0.2), 10, side, OrderType::Stop);
+        else
+        {
+            book.addOrder(i, 100.0+(side==Side::Buy ? -1 : 1)*(int(rng()%10)-2)*0.01, 1+rng()%50, side, OrderType::Limit);
+            live.push_back(i);
+        }
+        if(i==15000) book.reset();
+        drain();
+        if(i%250==0) REQUIRE(matchesBook());
+    }
+    REQUIRE(ring.dropped()==0);
+
+    // a crossing limit is never announced on its own side: only the resting order executes
+    book.reset();
+    book.addOrder(1, 100.0, 5, Side::Sell, OrderType::Limit);
+    book.addOrder(2, 100.0, 3, Side::Buy, OrderType::Limit);
+    OrderMessage m;
+    vector<OrderMessage> messages;
+    while(ring.poll(m)) messages.push_back(m);
+    REQUIRE(messages.size()==3);
+    REQUIRE(messages[0].type==OrderFeedType::Clear);
+    REQUIRE(messages[1].type==OrderFeedType::Add);
+    REQUIRE(messages[2].type==OrderFeedType::Execute);
+    REQUIRE(messages[2].orderId==1);
+    REQUIRE(messages[2].contraOrderId==2);
+    REQUIRE(messages[2].quantity==3);
+    // its remainder is announced after the executions, with the open quantity
+    book.addOrder(3, 100.0, 6, Side::Buy, OrderType::Limit);
+    messages.clear();
+    while(ring.poll(m)) messages.push_back(m);
+    REQUIRE(messages.size()==2);
+    REQUIRE(messages[0].type==OrderFeedType::Execute);
+    REQUIRE(messages[1].type==OrderFeedType::Add);
+    REQUIRE(messages[1].orderId==3);
+    REQUIRE(messages[1].quantity==4);
+}
+
+TEST_CASE("Conflated depth view converges for a slow reader", "[conflation]")
+{
+    using Book=BasicOrderBook<MapPriceLevels, NullMutex>;
+    Book book;
+    ConflatingPublisher publisher;
+    book.setConflatingPublisher(&publisher);
+
+    atomic<bool> done{false};
+    atomic<int> badViews{0};
+    int reads=0;
+    thread reader([&]() {
+        uint64_t seen=0;
+        DepthView view;
+        while(!done)
+        {
+            if(publisher.readIfNewer(seen, view))
+            {
+                reads++;
+                for(uint32_t i=1;i<view.bidCount;i++) if(view.bids[i].price>=view.bids[i-1].price) badViews++;
+                for(uint32_t i=1;i<view.askCount;i++) if(view.asks[i].price<=view.asks[i-1].price) badViews++;
+                for(uint32_t i=0;i<view.bidCount;i++) if(view.bids[i].quantity<=0 || view.bids[i].orderCount==0) badViews++;
+            }
+            this_thread::sleep_for(chrono::microseconds(200));  // polls far slower than the book changes
+        }
+    });
+    mt19937 rng(5);
+    vector<int> live;
+    for(int i=1;i<=100000;i++)
+    {
+        int roll=rng()%100;
+        Side side=rng()%2 ? Side::Buy : Side::Sell;
+        if(roll<20 && !live.empty()) book.cancelOrder(live[rng()%live.size()]);
+        else if(roll<27) book.addOrder(i, 0.0, 1+rng()%100, side, OrderType::Market);
+        else
+        {
+            book.addOrder(i, 100.0+(side==Side::Buy ? -1 : 1)*int(rng()%30)*0.01, 1+rng()%50, side, OrderType::Limit);
+            live.push_back(i);
+        }
+    }
+    done=true;
+    reader.join();
+    REQUIRE(badViews==0);
+    REQUIRE(reads>0);
+    REQUIRE(uint64_t(reads)<publisher.version());
+
+    // the latest view is the book now
+    DepthSnapshot expected;
+    book.captureDepth(depthViewLevels, expected);
+    DepthView view=publisher.latest();
+    REQUIRE(view.bidCount==expected.bids.size());
+    REQUIRE(view.askCount==expected.asks.size());
+    for(uint32_t i=0;i<view.bidCount;i++)
+    {
+        REQUIRE(view.bids[i].price==expected.bids[i].price);
+        REQUIRE(view.bids[i].quantity==expected.bids[i].quantity);
+        REQUIRE(view.bids[i].orderCount==expected.bids[i].orderCount);
+    }
+    for(uint32_t i=0;i<view.askCount;i++)
+        REQUIRE(view.asks[i].quantity==expected.asks[i].quantity);
+
+    // changes below the view do not republish it; reaching into it does
+    uint64_t version=publisher.version();
+    REQUIRE(view.bidCount==depthViewLevels);
+    book.addOrder(900001, 50.0, 5, Side::Buy, OrderType::Limit);
+    REQUIRE(publisher.version()==version);
+    book.addOrder(900002, book.getBestBid(), 5, Side::Buy, OrderType::Limit);
+    REQUIRE(publisher.version()==version+1);
+    REQUIRE(publisher.latest().bids[0].quantity==view.bids[0].quantity+5);
+
+    book.reset();
+    REQUIRE(publisher.latest().bidCount==0);
+    REQUIRE(publisher.latest().askCount==0);
+}
+
+TEMPLATE_TEST_CASE("Batch calls match the same single calls", "[batch]",
+                   (BasicOrderBook<MapPriceLevels, NullMutex>), OrderBook)
+{
+    TestType single, batched;
+    mt19937 rng(3);
+    vector<OrderRequest> adds;
+    for(int i=1;i<=256;i++)
+    {
+        OrderRequest r;
+        r.orderId=i%50==0 ? i-1 : i;    // the occasional duplicate ID
+        r.side=rng()%2 ? Side::Buy : Side::Sell;
+        r.quantity=1+rng()%40;
+        r.price=100.0+(r.side==Side::Buy ? -1 : 1)*(int(rng()%8)-2)*0.01;
+        int roll=rng()%20;
+        if(roll==0) r.orderType=OrderType::Market;
+        else if(roll==1) r.orderType=OrderType::IOC;
+        else if(roll==2) { r.orderType=OrderType::Stop; r.price=100.0+(r.side==Side::Buy ? 0.05 : -0.05); }
+        adds.push_back(r);
+    }
+    vector<ModifyRequest> modifies;
+    vector<int> cancels;
+    for(int i=0;i<64;i++)
+    {
+        modifies.push_back(ModifyRequest{int(1+rng()%300), int(1+rng()%30), 100.0+(int(rng()%9)-4)*0.01});
+        cancels.push_back(1+rng()%300);
+    }
+
+    vector<char> expected;
+    for(const OrderRequest &r : adds) expected.push_back(single.addOrder(r.orderId, r.price, r.quantity, r.side, r.orderType));
+    for(const ModifyRequest &m : modifies) expected.push_back(single.modifyOrder(m.orderId, m.newQuantity, m.newPrice));
+    for(int id : cancels) expected.push_back(single.cancelOrder(id));
+
+    bool results[256];
+    vector<char> got;
+    size_t accepted=batched.addOrders(adds.data(), adds.size(), results);
+    REQUIRE(accepted==size_t(count(results, results+adds.size(), true)));
+    got.insert(got.end(), results, results+adds.size());
+    batched.modifyOrders(modifies.data(), modifies.size(), results);
+    got.insert(got.end(), results, results+modifies.size());
+    batched.cancelOrders(cancels.data(), cancels.size(), results);
+    got.insert(got.end(), results, results+cancels.size());
+
+    REQUIRE(got==expected);
+    REQUIRE(count(expected.begin(), expected.begin()+adds.size(), false)>0);
+    REQUIRE(bookChecksum(batched)==bookChecksum(single));
+    REQUIRE(batched.pendingStopOrders()==single.pendingStopOrders());
+}
+
+TEMPLATE_TEST_CASE("A block trade sweeps whole levels in price-time order", "[sweep]",
+                   (BasicOrderBook<MapPriceLevels, NullMutex>), (BasicOrderBook<PriceLadder, NullMutex>))
+{
+    TestType book;
+    EventRing events(1<<12);
+    OrderFeedRing feed(1<<12);
+    book.setEventRing(&events);
+    book.setOrderFeed(&feed);
+    // 25 ask levels, 3 orders each (sizes 10, 20, 30), plus a zero-size order left by a modify
+    int id=1;
+    for(int level=0;level<25;level++)
+        for(int k=0;k<3;k++)
+            book.addOrder(id++, 100.0+level*0.01, 10*(k+1), Side::Sell, OrderType::Limit);
+    REQUIRE(book.modifyOrder(4, 0, 100.01));    // front of level 1 moves to its back with nothing left
+    BookEvent e;
+    while(events.poll(e)) {}
+    OrderMessage m;
+    while(feed.poll(m)) {}
+
+    // 20 whole levels (level 1 is 10 short after the modify), then 15 into the next level: all of its 10, 5 of its 20
+    int qty=20*60-10+15;
+    book.addOrder(id++, 0.0, qty, Side::Buy, OrderType::Market);
+    vector<int> filledIds;
+    int filled=0;
+    while(events.poll(e))
+        if(e.type==EventType::Fill)
+        {
+            if(!filledIds.empty()) REQUIRE(e.contraOrderId>filledIds.back());
+            filledIds.push_back(e.contraOrderId);
+            filled+=e.quantity;
+            REQUIRE(e.price==book.priceScale().toTicks(100.0+((e.contraOrderId-1)/3)*0.01));
+        }
+    REQUIRE(filled==qty);
+    REQUIRE(filledIds.size()==20*3-1+2);
+    REQUIRE(book.getBestAsk()==Approx(100.20));
+    REQUIRE(book.topOfBook().top.askQuantity==60-15);
+    size_t executes=0, deletes=0;
+    while(feed.poll(m))
+    {
+        if(m.type==OrderFeedType::Execute) executes++;
+        if(m.type==OrderFeedType::Delete) { deletes++; REQUIRE(m.orderId==4); }
+    }
+    REQUIRE(executes==filledIds.size());
+    REQUIRE(deletes==1);
+    REQUIRE(book.cancelOrder(62));              // the partially filled order still rests
+    REQUIRE_FALSE(book.cancelOrder(61));
+}
+
+TEST_CASE("Occupancy bitmap finds the nearest occupied tick", "[ladder]")
+{
+    SECTION("Matches a linear scan")
+    {
+        const long size=20000;  // several summary words, not a multiple of 64
+        OccupancyBitmap bitmap(size);
+        vector<bool> ref(size,false);
+        mt19937 rng(7);
+        uniform_int_distribution<long> pick(0,size-1);
+        for(int round=0;round<2000;round++)
+        {
+            long i=pick(rng);
+            if(ref[i]) bitmap.reset(i); else bitmap.set(i);
+            ref[i]=!ref[i];
+            long from=pick(rng);
+            long up=-1, down=-1;
+            for(long j=from;j<size;j++) if(ref[j]) { up=j; break; }
+            for(long j=from;j>=0;j--) if(ref[j]) { down=j; break; }
+            REQUIRE(bitmap.nextAtOrAbove(from)==up);
+            REQUIRE(bitmap.nextAtOrBelow(from)==down);
+        }
+        bitmap.clear();
+        REQUIRE(bitmap.nextAtOrAbove(0)==-1);
+        REQUIRE(bitmap.nextAtOrBelow(size-1)==-1);
+    }
+
+    SECTION("A wide, sparse ladder walks its levels best first")
+    {
+        PriceLadder::Config band{0.0, 10000.0};    // a million ticks
+        BasicOrderBook<PriceLadder, NullMutex> book({}, band);
+        const double asks[]={5000.00, 5000.01, 5123.45, 9999.99};
+        const double bids[]={4999.99, 4100.00, 0.01};
+        int id=1;
+        for(double p : asks) book.addOrder(id++, p, 10, Side::Sell, OrderType::Limit);
+        for(double p : bids) book.addOrder(id++, p, 10, Side::Buy, OrderType::Limit);
+
+        DepthSnapshot depth;
+        book.captureDepth(10, depth);
+        REQUIRE(depth.asks.size()==4);
+        REQUIRE(depth.bids.size()==3);
+        for(size_t i=0;i<4;i++) REQUIRE(depth.asks[i].price==book.priceScale().toTicks(asks[i]));
+        for(size_t i=0;i<3;i++) REQUIRE(depth.bids[i].price==book.priceScale().toTicks(bids[i]));
+
+        REQUIRE(book.cancelOrder(1));
+        REQUIRE(book.getBestAsk()==Approx(5000.01));
+        book.addOrder(id++, 0.0, 20, Side::Buy, OrderType::Market);   // empties 5000.01 and 5123.45
+        REQUIRE(book.getBestAsk()==Approx(9999.99));
+        REQUIRE(book.cancelOrder(5));
+        REQUIRE(book.getBestBid()==Approx(4100.00));
+        REQUIRE(book.cancelOrder(6));
+        REQUIRE(book.getBestBid()==Approx(0.01));
+        book.addOrder(id++, 0.01, 10, Side::Sell, OrderType::Limit);  // takes the last bid
+        book.captureDepth(10, depth);
+        REQUIRE(depth.bids.empty());
+        REQUIRE(depth.asks.size()==1);
+    }
+}